@@ -0,0 +1,223 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    bandMatrix.cc
+   Updated: October 2026
+
+   Definition of a class storing a banded matrix, possibly cyclic, and
+   solving linear systems with it in linear time.
+
+**********************************************************************/
+
+#include <cmath>
+#include "bandMatrix.h"
+
+// Constructor with the size and the half-width of the band.
+BandMatrix::BandMatrix(int n, int b, bool cyc)
+{
+    init(n, b, cyc);
+}
+
+// Reinitialize the matrix to a given size and band, all 0.
+void BandMatrix::init(int n, int b, bool cyc)
+{
+    size = n;
+    band = b;
+    // with too few rows the wrapped entries would overlap the band
+    cyclic = cyc && n > 4 * b;
+    data.assign(n * (2 * b + 1), 0);
+}
+
+// Access the entry in row i and column i+k, where -band <= k <= band.
+double &BandMatrix::at(int i, int k)
+{
+    return data[i * (2 * band + 1) + k + band];
+}
+
+// Access the entry in row i and column i+k, where -band <= k <= band.
+double BandMatrix::at(int i, int k) const
+{
+    return data[i * (2 * band + 1) + k + band];
+}
+
+// Offset in row i of the column j, or a value larger than band if the
+// entry is outside of the band.
+int BandMatrix::offset(int i, int j) const
+{
+    int k = j - i;
+    if (cyclic) {
+        if (k > band)
+            k -= size;
+        else if (k < -band)
+            k += size;
+    }
+    if (k < -band || k > band)
+        return band + 1;
+    return k;
+}
+
+// Add a value to the entry in row i and column j.
+void BandMatrix::add(int i, int j, double value)
+{
+    int k = offset(i, j);
+    if (k <= band)
+        at(i, k) += value;
+}
+
+// Multiply the matrix by the vector x and store the result in y.
+void BandMatrix::multiply(const vector<double> &x, vector<double> &y) const
+{
+    int i, j, k;
+    y.assign(size, 0);
+    for (i = 0; i < size; i++)
+        for (k = -band; k <= band; k++) {
+            j = i + k;
+            if (cyclic)
+                j = (j + size) % size;
+            else if (j < 0 || j >= size)
+                continue;
+            y[i] += at(i, k) * x[j];
+        }
+}
+
+// Fix the unknown i to a known value: its row and column are replaced
+// by those of the identity and the value is moved to the right side.
+void BandMatrix::fixValue(int i, double value, vector<double> &rhs)
+{
+    int j, k, kj;
+    for (k = -band; k <= band; k++) {
+        j = i + k;
+        if (cyclic)
+            j = (j + size) % size;
+        else if (j < 0 || j >= size)
+            continue;
+        at(i, k) = 0;
+        if (j == i)
+            continue;
+        // the entry in row j and column i becomes a known term
+        kj = offset(j, i);
+        rhs[j] -= at(j, kj) * value;
+        at(j, kj) = 0;
+    }
+    at(i, 0) = 1;
+    rhs[i] = value;
+}
+
+// LU factorization of the band part of the matrix in place, without
+// the entries wrapping around.
+bool BandMatrix::factor(vector<double> &lu) const
+{
+    int p, r, c, width = 2 * band + 1;
+    double l, pivot;
+    lu = data;
+    for (p = 0; p < size; p++) {
+        pivot = lu[p * width + band];
+        if (fabs(pivot) < 1e-300)
+            return false;
+        for (r = p + 1; r <= p + band && r < size; r++) {
+            l = lu[r * width + p - r + band] / pivot;
+            lu[r * width + p - r + band] = l;
+            for (c = p + 1; c <= p + band && c < size; c++)
+                lu[r * width + c - r + band] -= l * lu[p * width + c - p + band];
+        }
+    }
+    return true;
+}
+
+// Solve the system with the band part of the matrix already factored.
+void BandMatrix::substitute(const vector<double> &lu, vector<double> &x) const
+{
+    int i, c, width = 2 * band + 1;
+    // forward: L has 1 on the diagonal
+    for (i = 1; i < size; i++)
+        for (c = (i - band > 0 ? i - band : 0); c < i; c++)
+            x[i] -= lu[i * width + c - i + band] * x[c];
+    // backward
+    for (i = size - 1; i >= 0; i--) {
+        for (c = i + 1; c <= i + band && c < size; c++)
+            x[i] -= lu[i * width + c - i + band] * x[c];
+        x[i] /= lu[i * width + band];
+    }
+}
+
+// Solve the system with the right-hand side rhs and store the result
+// in x. The band part is factored without pivoting, so the matrix
+// should be diagonally dominant or positive definite. Returns false
+// if a pivot is 0.
+bool BandMatrix::solve(const vector<double> &rhs, vector<double> &x) const
+{
+    vector<double> lu;
+    if (!factor(lu))
+        return false;
+    x = rhs;
+    substitute(lu, x);
+    if (!cyclic)
+        return true;
+
+    // The wrapped entries of the first and last band rows are a low rank
+    // correction U V^T of the band part B, with U made of the unit vectors
+    // of these rows. Woodbury: x = y - Z (I + V^T Z)^-1 V^T y, with B y = rhs
+    // and B Z = U, so only 2*band more band solves are needed.
+    int m = 2 * band, i, j, l, k, col, piv;
+    vector<int> rows(m);
+    vector<vector<double> > z(m);
+    vector<double> mat(m * m, 0), v(m, 0);
+    double coef, tmp;
+    for (j = 0; j < band; j++) {
+        rows[j] = j;
+        rows[band + j] = size - band + j;
+    }
+    for (j = 0; j < m; j++) {
+        z[j].assign(size, 0);
+        z[j][rows[j]] = 1;
+        substitute(lu, z[j]);
+    }
+    for (j = 0; j < m; j++) {
+        mat[j * m + j] = 1;
+        for (k = -band; k <= band; k++) {
+            col = rows[j] + k;
+            if (col >= 0 && col < size)
+                continue; // not a wrapped entry
+            col = (col + size) % size;
+            coef = at(rows[j], k);
+            v[j] += coef * x[col];
+            for (l = 0; l < m; l++)
+                mat[j * m + l] += coef * z[l][col];
+        }
+    }
+    // small dense system, Gaussian elimination with partial pivoting
+    for (j = 0; j < m; j++) {
+        piv = j;
+        for (i = j + 1; i < m; i++)
+            if (fabs(mat[i * m + j]) > fabs(mat[piv * m + j]))
+                piv = i;
+        if (fabs(mat[piv * m + j]) < 1e-300)
+            return false;
+        if (piv != j) {
+            for (l = 0; l < m; l++) {
+                tmp = mat[j * m + l];
+                mat[j * m + l] = mat[piv * m + l];
+                mat[piv * m + l] = tmp;
+            }
+            tmp = v[j];
+            v[j] = v[piv];
+            v[piv] = tmp;
+        }
+        for (i = j + 1; i < m; i++) {
+            coef = mat[i * m + j] / mat[j * m + j];
+            for (l = j; l < m; l++)
+                mat[i * m + l] -= coef * mat[j * m + l];
+            v[i] -= coef * v[j];
+        }
+    }
+    for (j = m - 1; j >= 0; j--) {
+        for (l = j + 1; l < m; l++)
+            v[j] -= mat[j * m + l] * v[l];
+        v[j] /= mat[j * m + j];
+    }
+    for (j = 0; j < m; j++)
+        for (i = 0; i < size; i++)
+            x[i] -= z[j][i] * v[j];
+    return true;
+}
@@ -0,0 +1,68 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    bandMatrix.h
+   Updated: October 2026
+
+   Definition of a class storing a banded matrix, possibly cyclic, and
+   solving linear systems with it in linear time.
+
+**********************************************************************/
+
+#ifndef BAND_MATRIX_H
+#define BAND_MATRIX_H
+
+#include <vector>
+using namespace std;
+
+// A square matrix in which row i only has entries in the columns
+// i-band to i+band. If the matrix is cyclic, the column indexes wrap
+// around, so the first rows also reach the last columns and the last
+// rows reach the first ones, like for a closed track.
+class BandMatrix {
+public:
+    int size, band;
+    bool cyclic;
+    vector<double> data; // row i is stored at data[i * (2*band+1)]
+
+    // Constructor with the size and the half-width of the band.
+    BandMatrix(int n = 0, int b = 1, bool cyc = false);
+
+    // Reinitialize the matrix to a given size and band, all 0.
+    void init(int n, int b, bool cyc);
+
+    // Access the entry in row i and column i+k, where -band <= k <= band.
+    double &at(int i, int k);
+    double at(int i, int k) const;
+
+    // Offset in row i of the column j, or a value larger than band if the
+    // entry is outside of the band.
+    int offset(int i, int j) const;
+
+    // Add a value to the entry in row i and column j.
+    void add(int i, int j, double value);
+
+    // Multiply the matrix by the vector x and store the result in y.
+    void multiply(const vector<double> &x, vector<double> &y) const;
+
+    // Fix the unknown i to a known value: its row and column are replaced
+    // by those of the identity and the value is moved to the right side.
+    void fixValue(int i, double value, vector<double> &rhs);
+
+    // Solve the system with the right-hand side rhs and store the result
+    // in x. The band part is factored without pivoting, so the matrix
+    // should be diagonally dominant or positive definite. Returns false
+    // if a pivot is 0.
+    bool solve(const vector<double> &rhs, vector<double> &x) const;
+
+private:
+    // LU factorization of the band part of the matrix in place, without
+    // the entries wrapping around.
+    bool factor(vector<double> &lu) const;
+
+    // Solve the system with the band part of the matrix already factored.
+    void substitute(const vector<double> &lu, vector<double> &x) const;
+};
+
+#endif
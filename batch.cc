@@ -0,0 +1,356 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    batch.cc
+   Updated: October 2026
+
+   The batch mode: loads a list of tracks, optimizes their trajectory
+   and exports the results without opening a window.
+
+**********************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include "batch.h"
+#include "road.h"
+#include "threadPool.h"
+#include "softRender.h"
+#include "trace.h"
+#include "log.h"
+
+namespace fs = std::filesystem;
+
+#define BATCH_INC 0.05   // default increment of the trajectory optimization
+#define BATCH_FLAT 0.001 // default curvature below which a point is flat
+
+// Seconds since an arbitrary start.
+static double now()
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The Road functions take the file names as char *; they don't change them.
+static char *fileName(string &name)
+{
+    return &name[0];
+}
+
+// Constructor with the default settings.
+BatchJob::BatchJob()
+{
+    center = false;
+    interp = linear;
+    step = 0.2;
+    optimize = 0;
+    // the road starts with an increment of 0 and a flat threshold that no
+    // point of a finely sampled road reaches, so nothing would move
+    inc = BATCH_INC;
+    flat = BATCH_FLAT;
+    curvScale = 2;
+    smooth = 0;
+    radius = 10;
+    outDir = ".";
+    png = false;
+    nrPoints = 0;
+    ok = false;
+    loadTime = optTime = exportTime = 0;
+}
+
+// Output the options of the batch mode.
+static void batchUsage()
+{
+    cout << "Usage: roadviz batch [options] tracks or directories..." << endl
+         << "  -curv          the tracks are given as distance and curvature (default)" << endl
+         << "  -center        the tracks are given as centerline points" << endl
+         << "  -interp type   interpolation of the centerline: none or linear (default)" << endl
+         << "  -step s        distance between the interpolated points (default 0.2)" << endl
+         << "  -traj file     start from the trajectory in the file" << endl
+         << "  -optimize n    passes of the trajectory optimization" << endl
+         << "  -inc d         change of the trajectory in a pass (default " << BATCH_INC << ")" << endl
+         << "  -flat c        curvature of the trajectory left alone (default " << BATCH_FLAT << ")" << endl
+         << "  -curvScale f   scale of the curvature in a pass (default 2)" << endl
+         << "  -smooth n      passes of smoothing the trajectory" << endl
+         << "  -radius r      radius of the smoothing (default 10)" << endl
+         << "  -out dir       directory for the results (default .)" << endl
+         << "  -png           also draw a picture of each track" << endl
+         << "  -threads n     number of tracks processed at the same time" << endl
+         << "  -jobs file     read more jobs from a file, one per line" << endl
+         << "The options apply to the tracks that come after them." << endl;
+}
+
+// Parse the options from args, starting at the index first, into settings. The
+// tracks are added to jobs with the settings they have at that point; a directory
+// adds all the files in it. Returns false if an option is not valid.
+bool parseBatchArgs(vector<string> &args, int first, BatchJob &settings,
+                    vector<BatchJob> &jobs, int &nrThreads)
+{
+    for (int i = first; i < args.size(); i++) {
+        string &arg = args[i];
+        if (arg[0] != '-') {
+            // a track, or a directory of tracks
+            error_code err;
+            if (fs::is_directory(arg, err)) {
+                vector<string> names;
+                for (fs::directory_iterator it(arg, err), end; !err && it != end; it.increment(err))
+                    if (it->is_regular_file(err) && it->path().filename().string()[0] != '.')
+                        names.push_back(it->path().string());
+                sort(names.begin(), names.end());
+                for (int j = 0; j < names.size(); j++) {
+                    jobs.push_back(settings);
+                    jobs.back().track = names[j];
+                }
+            }
+            else {
+                jobs.push_back(settings);
+                jobs.back().track = arg;
+            }
+            continue;
+        }
+        if ((arg == "-interp" || arg == "-step" || arg == "-traj" || arg == "-optimize" ||
+             arg == "-inc" || arg == "-flat" || arg == "-curvScale" || arg == "-smooth" ||
+             arg == "-radius" || arg == "-out" || arg == "-threads" || arg == "-jobs") &&
+            i + 1 >= args.size()) {
+            cout << "Missing value for the option " << arg << endl;
+            return false;
+        }
+        if (arg == "-center")
+            settings.center = true;
+        else if (arg == "-curv")
+            settings.center = false;
+        else if (arg == "-png")
+            settings.png = true;
+        else if (arg == "-interp") {
+            string &type = args[++i];
+            if (type == "none")
+                settings.interp = none;
+            else if (type == "linear")
+                settings.interp = linear;
+            else if (type == "quadr") {
+                // readCenter doesn't resample with it, the road would be the one of none
+                cout << "The quadratic interpolation is not supported in batch" << endl;
+                return false;
+            }
+            else {
+                cout << "Unknown interpolation type " << type << endl;
+                return false;
+            }
+        }
+        else if (arg == "-step") {
+            settings.step = atof(args[++i].c_str());
+            if (settings.step <= 0) {
+                cout << "The step must be positive" << endl;
+                return false;
+            }
+        }
+        else if (arg == "-traj")
+            settings.trajFile = args[++i];
+        else if (arg == "-optimize")
+            settings.optimize = atoi(args[++i].c_str());
+        else if (arg == "-inc" || arg == "-flat" || arg == "-curvScale") {
+            float value = atof(args[++i].c_str());
+            if (value <= 0) {
+                cout << "The value of " << arg << " must be positive" << endl;
+                return false;
+            }
+            if (arg == "-inc")
+                settings.inc = value;
+            else if (arg == "-flat")
+                settings.flat = value;
+            else
+                settings.curvScale = value;
+        }
+        else if (arg == "-smooth")
+            settings.smooth = atoi(args[++i].c_str());
+        else if (arg == "-radius")
+            settings.radius = atoi(args[++i].c_str());
+        else if (arg == "-out")
+            settings.outDir = args[++i];
+        else if (arg == "-threads")
+            nrThreads = atoi(args[++i].c_str());
+        else if (arg == "-jobs") {
+            // the job file doesn't change the settings on the command line
+            BatchJob fileSettings = settings;
+            if (!readJobFile(args[++i].c_str(), fileSettings, jobs, nrThreads))
+                return false;
+        }
+        else {
+            cout << "Unknown option " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Read the jobs from a file: each line holds options and tracks, as on the
+// command line, starting from the given settings. Empty lines and lines
+// starting with # are skipped. Returns false if the file cannot be read.
+bool readJobFile(const char *filename, BatchJob &settings, vector<BatchJob> &jobs,
+                 int &nrThreads)
+{
+    ifstream fin(filename);
+    string line, word;
+    int lineNr = 0;
+    if (!fin.good()) {
+        cout << "Could not open the job file " << filename << endl;
+        return false;
+    }
+    while (getline(fin, line)) {
+        lineNr++;
+        istringstream words(line);
+        vector<string> args;
+        while (words >> word)
+            args.push_back(word);
+        if (args.empty() || args[0][0] == '#')
+            continue;
+        BatchJob lineSettings = settings;
+        if (!parseBatchArgs(args, 0, lineSettings, jobs, nrThreads)) {
+            cout << "in the job file " << filename << " at line " << lineNr << endl;
+            return false;
+        }
+    }
+    fin.close();
+    return true;
+}
+
+// Load the track, optimize its trajectory, and write the trajectory, the real
+// points and the keyframes in the output directory.
+void runJob(BatchJob &job)
+{
+    TRACE_SCOPE("runJob");
+    double start = now();
+    Road rd;
+    string base = (fs::path(job.outDir) / fs::path(job.track).stem()).string(),
+           trajName = base + "_traj.txt", realName = base + "_real.txt",
+           keyName = base + "_keyframes.txt", pngName = base + ".png";
+
+    job.ok = false;
+    if (job.center) {
+        if (job.interp == none)
+            rd.readCenter(fileName(job.track));
+        else
+            rd.readCenter(fileName(job.track), job.interp, job.step);
+    }
+    else
+        rd.read(fileName(job.track));
+    job.nrPoints = rd.points.size();
+    if (job.nrPoints < 3) {
+        LOG(logError, "Could not load a road from " << job.track);
+        job.loadTime = now() - start;
+        return;
+    }
+    if (job.trajFile.size())
+        rd.readTrajFile(fileName(job.trajFile), false);
+    else
+        rd.setConstTraj(0, false);
+    job.loadTime = now() - start;
+
+    start = now();
+    rd.inc = job.inc;
+    rd.almostFlat = job.flat;
+    rd.curvScale = job.curvScale;
+    vector<float> before(job.optimize > 0 ? rd.points.size() : 0);
+    for (int i = 0; i < before.size(); i++)
+        before[i] = rd.points[i].traj;
+    for (int i = 0; i < job.optimize; i++)
+        rd.optimizeTraj(false);
+    if (job.optimize > 0) {
+        int moved = 0;
+        for (int i = 0; i < before.size(); i++)
+            if (rd.points[i].traj != before[i])
+                moved++;
+        if (moved == 0)
+            LOG(logWarn, "The optimization didn't change the trajectory of " << job.track
+                << "; -inc and -flat set how much it moves");
+        else
+            LOG(logInfo, "The optimization moved " << moved << " points of " << job.track);
+    }
+    if (rd.points.size() > 2 * job.radius)
+        for (int i = 0; i < job.smooth; i++)
+            rd.smoothTrajectory(job.radius, false);
+    job.optTime = now() - start;
+
+    start = now();
+    rd.writeTrajFile(fileName(trajName));
+    rd.writeRealPts(fileName(realName));
+    rd.computeCurvChangePts(false);
+    rd.writeKeyFrames(fileName(keyName));
+    if (job.png) {
+        SoftRender picture;
+        picture.fitView(rd);
+        picture.drawRoad(rd);
+        picture.write(pngName.c_str());
+    }
+    job.exportTime = now() - start;
+    job.ok = true;
+}
+
+// Run all the jobs on a pool of threads and output the time of each of them.
+// Returns the number of jobs that failed.
+int runJobs(vector<BatchJob> &jobs, int nrThreads)
+{
+    vector<pair<uintmax_t, int> > order;
+    double start = now();
+    int failed = 0;
+    error_code err;
+
+    // the largest files first, so that a long job doesn't start last
+    for (int i = 0; i < jobs.size(); i++) {
+        uintmax_t size = fs::file_size(jobs[i].track, err);
+        order.push_back(make_pair(err ? 0 : size, i));
+    }
+    sort(order.begin(), order.end(), greater<pair<uintmax_t, int> >());
+    {
+        ThreadPool pool(nrThreads);
+        TaskGroup group(pool);
+        for (int i = 0; i < order.size(); i++) {
+            BatchJob *job = &jobs[order[i].second];
+            group.run([job]() { runJob(*job); });
+        }
+        group.wait();
+    }
+
+    logFlush(); // the messages of the jobs come before the table
+    cout << endl << "Track\tPoints\tLoad\tOptimize\tExport\tTotal" << endl;
+    cout << fixed << setprecision(3);
+    for (int i = 0; i < jobs.size(); i++) {
+        BatchJob &job = jobs[i];
+        cout << job.track << "\t" << job.nrPoints << "\t" << job.loadTime << "\t"
+             << job.optTime << "\t" << job.exportTime << "\t"
+             << job.loadTime + job.optTime + job.exportTime
+             << (job.ok ? "" : "\tfailed") << endl;
+        if (!job.ok)
+            failed++;
+    }
+    cout << jobs.size() << " jobs, " << failed << " failed, in " << now() - start
+         << " seconds" << endl;
+    return failed;
+}
+
+// Main function of the batch mode, called with the arguments after "batch".
+int batchMain(int argc, char **argv)
+{
+    vector<string> args(argv, argv + argc);
+    vector<BatchJob> jobs;
+    BatchJob settings;
+    int nrThreads = 0;
+    if (!parseBatchArgs(args, 0, settings, jobs, nrThreads)) {
+        batchUsage();
+        return 2;
+    }
+    if (jobs.empty()) {
+        batchUsage();
+        return 2;
+    }
+    for (int i = 0; i < jobs.size(); i++) {
+        error_code err;
+        fs::create_directories(jobs[i].outDir, err);
+    }
+    return runJobs(jobs, nrThreads) ? 1 : 0;
+}
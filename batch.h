@@ -0,0 +1,65 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    batch.h
+   Updated: October 2026
+
+   The batch mode: loads a list of tracks, optimizes their trajectory
+   and exports the results without opening a window.
+
+**********************************************************************/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+using namespace std;
+#include "roadPt.h"
+
+// Everything needed to process one track, and the time each step took.
+struct BatchJob {
+    string track;       // the road file
+    bool center;        // the file contains centerline points, not distance and curvature
+    InterpType interp;  // interpolation of the centerline points
+    float step;         // distance between the interpolated centerline points
+    string trajFile;    // a trajectory to start from, none if empty
+    int optimize;       // number of passes of optimizeTraj
+    float inc, flat, curvScale; // settings of the road used by optimizeTraj
+    int smooth, radius; // number of passes of smoothTrajectory with this radius
+    string outDir;      // where the results are written
+    bool png;           // also draw a picture of the road
+
+    int nrPoints;
+    bool ok;
+    double loadTime, optTime, exportTime; // in seconds
+
+    // Constructor with the default settings.
+    BatchJob();
+};
+
+// Parse the options from args, starting at the index first, into settings. The
+// tracks are added to jobs with the settings they have at that point; a directory
+// adds all the files in it. Returns false if an option is not valid.
+bool parseBatchArgs(vector<string> &args, int first, BatchJob &settings,
+                    vector<BatchJob> &jobs, int &nrThreads);
+
+// Read the jobs from a file: each line holds options and tracks, as on the
+// command line, starting from the given settings. Empty lines and lines
+// starting with # are skipped. Returns false if the file cannot be read.
+bool readJobFile(const char *filename, BatchJob &settings, vector<BatchJob> &jobs,
+                 int &nrThreads);
+
+// Load the track, optimize its trajectory, and write the trajectory, the real
+// points and the keyframes in the output directory.
+void runJob(BatchJob &job);
+
+// Run all the jobs on a pool of threads and output the time of each of them.
+// Returns the number of jobs that failed.
+int runJobs(vector<BatchJob> &jobs, int nrThreads);
+
+// Main function of the batch mode, called with the arguments after "batch".
+int batchMain(int argc, char **argv);
+
+#endif
@@ -0,0 +1,388 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    bench.cc
+   Updated: October 2026
+
+   Benchmark of the stages of the road pipeline, built with "make
+   bench". Each stage is timed several times on the shipped tracks
+   and on longer synthetic ones, and the results are output as JSON
+   that a later run can be compared to.
+
+**********************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <filesystem>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "road.h"
+#include "roadGen.h"
+#include "log.h"
+
+namespace fs = std::filesystem;
+
+#define BENCH_EDIT 100 // points of the trajectory changed by a local edit
+
+// The timing of one stage of the pipeline on one track.
+struct BenchResult {
+    string track, stage;
+    int points;               // size of the road
+    double median, p95, best; // in milliseconds
+    long peakRSS;             // peak memory of the process so far, in KB; it never goes down
+    long rssDelta;            // change of the resident memory over the last run, in KB
+};
+
+// Seconds since an arbitrary start.
+static double now()
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Peak resident memory of the process in KB.
+static long peakRSS()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Current resident memory of the process in KB, 0 if it can't be read.
+static long currentRSS()
+{
+    ifstream fin("/proc/self/statm");
+    long size = 0, resident = 0;
+    if (!(fin >> size >> resident))
+        return 0;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// The Road functions take the file names as char *; they don't change them.
+static char *fileName(string &name)
+{
+    return &name[0];
+}
+
+// Time run reps times after one run to warm up, calling setup before each run
+// without timing it.
+static BenchResult timeStage(const string &track, const string &stage, int points, int reps,
+                             function<void()> setup, function<void()> run)
+{
+    BenchResult result;
+    vector<double> times;
+    long rss = 0;
+    for (int r = 0; r <= reps; r++) {
+        setup();
+        rss = currentRSS();
+        double start = now();
+        run();
+        if (r > 0)
+            times.push_back(1000 * (now() - start));
+    }
+    result.rssDelta = currentRSS() - rss;
+    sort(times.begin(), times.end());
+    result.track = track;
+    result.stage = stage;
+    result.points = points;
+    result.median = times[times.size() / 2];
+    result.p95 = times[min(times.size() - 1, size_t(0.95 * times.size()))];
+    result.best = times[0];
+    result.peakRSS = peakRSS();
+    cerr << setw(24) << left << track << setw(24) << stage << right << fixed
+         << setprecision(3) << setw(12) << result.median << " ms" << endl;
+    return result;
+}
+
+// Write a track made of the curvature file src repeated scale times in dst.
+static bool makeScaledTrack(const string &src, int scale, const string &dst)
+{
+    ifstream fin(src);
+    ofstream fout(dst);
+    vector<pair<float, float> > data;
+    float dist, curv, offset = 0;
+    while (fin >> dist >> curv)
+        data.push_back(make_pair(dist, curv));
+    if (data.empty() || !fout.good())
+        return false;
+    for (int s = 0; s < scale; s++) {
+        for (int i = 0; i < data.size(); i++)
+            fout << offset + data[i].first << "\t" << data[i].second << "\n";
+        offset += data.back().first;
+    }
+    return true;
+}
+
+// Write the points of a road in dst as a centerline file.
+static void writeCenterline(Road &rd, const string &dst)
+{
+    ofstream fout(dst);
+    fout << rd.points.size() << " " << rd.points.back().dist << "\n";
+    for (int i = 0; i < rd.points.size(); i++)
+        fout << rd.points[i].pt.x() << " " << rd.points[i].pt.y() << "\n";
+}
+
+// Run all the stages on the curvature file track, using work for the files
+// they write, and add the results to results.
+static void benchTrack(const string &track, const string &name, const string &work, int reps,
+                       vector<BenchResult> &results)
+{
+    Road rd, loaded;
+    string center = work + "/" + name + "_center.txt", traj = work + "/" + name + "_traj.txt",
+           real = work + "/" + name + "_real.txt", keys = work + "/" + name + "_keys.txt",
+           file = track;
+    int n;
+
+    rd.read(fileName(file));
+    n = rd.points.size();
+    if (n < 3) {
+        cerr << "Could not load a road from " << track << endl;
+        return;
+    }
+    writeCenterline(rd, center);
+
+    // loading
+    results.push_back(timeStage(name, "readPointList allScale", n, reps,
+        [&]() { loaded = Road(); },
+        [&]() { loaded.read(fileName(file)); }));
+    results.push_back(timeStage(name, "readPointList skipStep", n, reps,
+        [&]() { loaded = Road(); loaded.rdType = skipStep; },
+        [&]() { loaded.read(fileName(file)); }));
+    results.push_back(timeStage(name, "readCenterList linear", n, reps,
+        [&]() { loaded = Road(); },
+        [&]() { loaded.readCenter(fileName(center), linear, 0.2); }));
+    results.push_back(timeStage(name, "readCenterList quadr", n, reps,
+        [&]() { loaded = Road(); },
+        [&]() { loaded.readCenter(fileName(center), quadr, 0.2); }));
+    loaded = Road();
+
+    // trajectory, with settings that move it: with those of init, inc is 0
+    // and optimizeTraj changes nothing
+    rd.inc = 0.05;
+    rd.almostFlat = 0.001;
+    results.push_back(timeStage(name, "optimizeTraj", n, reps,
+        [&]() { rd.setConstTraj(0, false); },
+        [&]() { rd.optimizeTraj(false); }));
+    results.push_back(timeStage(name, "smoothTrajectory", n, reps,
+        [&]() {},
+        [&]() { rd.smoothTrajectory(10, false); }));
+    results.push_back(timeStage(name, "writeTrajFile", n, reps,
+        [&]() {},
+        [&]() { rd.writeTrajFile(fileName(traj)); }));
+    results.push_back(timeStage(name, "readTrajFile", n, reps,
+        [&]() {},
+        [&]() { rd.readTrajFile(fileName(traj), false); }));
+    results.push_back(timeStage(name, "writeRealPts", n, reps,
+        [&]() {},
+        [&]() { rd.writeRealPts(fileName(real)); }));
+    results.push_back(timeStage(name, "findKeyFrames", n, reps,
+        [&]() { rd.keyframes.clear(); },
+        [&]() { rd.findKeyFrames(); }));
+    results.push_back(timeStage(name, "computeCurvChangePts", n, reps,
+        [&]() { rd.keyframes.clear(); },
+        [&]() { rd.computeCurvChangePts(false); }));
+    results.push_back(timeStage(name, "writeKeyFrames", n, reps,
+        [&]() {},
+        [&]() { rd.writeKeyFrames(fileName(keys)); }));
+    results.push_back(timeStage(name, "sumDistance", n, reps,
+        [&]() {},
+        [&]() { rd.sumDistance(0, n - 1); }));
+    results.push_back(timeStage(name, "sumCurv", n, reps,
+        [&]() {},
+        [&]() { rd.sumCurv(0, n - 1); }));
+    results.push_back(timeStage(name, "scoreTraj", n, reps,
+        [&]() {},
+        [&]() { rd.scoreTraj(0, n); }));
+    // a local edit of the trajectory as made by a mutation, scored again
+    int editStart = n / 2, editEnd = min(n, editStart + BENCH_EDIT);
+    results.push_back(timeStage(name, "rescoreTraj", n, reps,
+        [&]() {
+            for (int i = editStart; i < editEnd; i++)
+                rd.points[i].traj = -rd.points[i].traj;
+        },
+        [&]() { rd.rescoreTraj(editStart, editEnd); }));
+    results.push_back(timeStage(name, "findMaxCurv", n, reps,
+        [&]() {},
+        [&]() { rd.findMaxCurv(0, n - 1); }));
+}
+
+// Output the results as JSON, one stage per line.
+static void writeJSON(ostream &out, vector<BenchResult> &results, int reps)
+{
+    out << "{" << endl;
+#ifdef __VERSION__
+    out << "  \"compiler\": \"" << __VERSION__ << "\"," << endl;
+#endif
+#ifdef __OPTIMIZE__
+    out << "  \"optimized\": true," << endl;
+#else
+    out << "  \"optimized\": false," << endl;
+#endif
+    out << "  \"threads\": " << thread::hardware_concurrency() << "," << endl;
+    out << "  \"reps\": " << reps << "," << endl;
+    out << "  \"stages\": [" << endl;
+    out << fixed;
+    for (int i = 0; i < results.size(); i++) {
+        BenchResult &r = results[i];
+        out << "    {\"track\": \"" << r.track << "\", \"stage\": \"" << r.stage
+            << "\", \"points\": " << r.points << setprecision(4)
+            << ", \"median_ms\": " << r.median << ", \"p95_ms\": " << r.p95
+            << ", \"min_ms\": " << r.best << setprecision(0)
+            << ", \"points_per_s\": " << (r.median > 0 ? 1000 * r.points / r.median : 0)
+            << ", \"rss_delta_kb\": " << r.rssDelta
+            << ", \"process_peak_rss_kb\": " << r.peakRSS << "}"
+            << (i < results.size() - 1 ? "," : "") << endl;
+    }
+    out << "  ]" << endl << "}" << endl;
+}
+
+// The value of the key in a line written by writeJSON, as a string.
+static string jsonValue(const string &line, const string &key)
+{
+    size_t pos = line.find("\"" + key + "\": ");
+    if (pos == string::npos)
+        return "";
+    pos += key.size() + 4;
+    if (line[pos] == '"')
+        return line.substr(pos + 1, line.find('"', pos + 1) - pos - 1);
+    return line.substr(pos, line.find_first_of(",}", pos) - pos);
+}
+
+// Compare the medians to the ones in a file written by a previous run and output
+// the ratios. Returns the number of stages slower by more than tolerance.
+static int compareBaseline(const char *filename, vector<BenchResult> &results, float tolerance)
+{
+    ifstream fin(filename);
+    string line;
+    int slower = 0;
+    if (!fin.good()) {
+        cerr << "Could not open the baseline " << filename << endl;
+        return 0;
+    }
+    cerr << endl << setw(24) << left << "Track" << setw(24) << "Stage" << right
+         << setw(12) << "Baseline" << setw(12) << "Now" << setw(8) << "Ratio" << endl;
+    while (getline(fin, line)) {
+        string track = jsonValue(line, "track"), stage = jsonValue(line, "stage");
+        if (track.empty())
+            continue;
+        double base = atof(jsonValue(line, "median_ms").c_str());
+        for (int i = 0; i < results.size(); i++)
+            if (results[i].track == track && results[i].stage == stage) {
+                double ratio = base > 0 ? results[i].median / base : 1;
+                bool slow = ratio > 1 + tolerance;
+                cerr << setw(24) << left << track << setw(24) << stage << right << fixed
+                     << setprecision(3) << setw(12) << base << setw(12) << results[i].median
+                     << setprecision(2) << setw(8) << ratio << (slow ? "  slower" : "") << endl;
+                if (slow)
+                    slower++;
+            }
+    }
+    return slower;
+}
+
+// Output the options of the benchmark.
+static void benchUsage()
+{
+    cerr << "Usage: roadbench [options]" << endl
+         << "  -reps n          timed runs of each stage, after one to warm up (default 7)" << endl
+         << "  -data dir        directory of the shipped tracks (default .)" << endl
+         << "  -scales list     synthetic tracks made of curvEroadL.txt repeated, as in 10,100" << endl
+         << "                   (default 10)" << endl
+         << "  -gen list        generated closed tracks of these numbers of points, as in" << endl
+         << "                   100000,1000000 (default none)" << endl
+         << "  -out file        write the JSON in the file instead of the output" << endl
+         << "  -baseline file   compare to the JSON of a previous run" << endl
+         << "  -tolerance t     slowdown reported as a regression (default 0.1)" << endl
+         << "The exit code is 1 if a stage is slower than the baseline." << endl;
+}
+
+// Run the benchmark and output the results.
+int main(int argc, char **argv)
+{
+    int reps = 7;
+    string data = ".", scales = "10", sizes, outFile, baseline;
+    float tolerance = 0.1;
+    setLogLevel(logError); // the messages of the Road functions would mix with the JSON
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            benchUsage();
+            return 2;
+        }
+        if (!strcmp(argv[i], "-reps"))
+            reps = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "-data"))
+            data = argv[++i];
+        else if (!strcmp(argv[i], "-scales"))
+            scales = argv[++i];
+        else if (!strcmp(argv[i], "-gen"))
+            sizes = argv[++i];
+        else if (!strcmp(argv[i], "-out"))
+            outFile = argv[++i];
+        else if (!strcmp(argv[i], "-baseline"))
+            baseline = argv[++i];
+        else if (!strcmp(argv[i], "-tolerance"))
+            tolerance = atof(argv[++i]);
+        else {
+            benchUsage();
+            return 2;
+        }
+    }
+
+    error_code err;
+    // a directory of its own, so that two runs at the same time don't remove each other's files
+    string work = (fs::temp_directory_path(err) / ("roadbench_" + to_string(getpid()))).string();
+    fs::create_directories(work, err);
+    vector<BenchResult> results;
+    const char *tracks[] = {"alpine2CahP2.txt", "curvEroadL.txt"};
+    for (int i = 0; i < 2; i++)
+        benchTrack(data + "/" + tracks[i], tracks[i], work, reps, results);
+
+    // longer tracks made of the same curves, so that the numbers don't depend on the data
+    istringstream list(scales);
+    string scale;
+    while (getline(list, scale, ',')) {
+        int s = atoi(scale.c_str());
+        if (s < 1)
+            continue;
+        string name = "curvEroadLx" + scale + ".txt", file = work + "/" + name;
+        if (!makeScaledTrack(data + "/curvEroadL.txt", s, file)) {
+            cerr << "Could not make the track " << name << endl;
+            continue;
+        }
+        benchTrack(file, name, work, reps, results);
+    }
+
+    // generated tracks of controlled size, always the same for a given size
+    istringstream genList(sizes);
+    string size;
+    while (getline(genList, size, ',')) {
+        long long n = atoll(size.c_str());
+        if (n < 3)
+            continue;
+        string name = "gen" + size + ".txt", file = work + "/" + name;
+        if (!writeGenRoad(file.c_str(), n, 0.2, 1, true, false)) {
+            cerr << "Could not make the track " << name << endl;
+            continue;
+        }
+        benchTrack(file, name, work, reps, results);
+    }
+
+    if (outFile.size()) {
+        ofstream fout(outFile);
+        writeJSON(fout, results, reps);
+    }
+    else
+        writeJSON(cout, results, reps);
+    fs::remove_all(work, err);
+    if (baseline.size() && compareBaseline(baseline.c_str(), results, tolerance))
+        return 1;
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    computeWorker.cc
+   Updated: October 2026
+
+   Definition of a class running the trajectory computations on a
+   thread of their own, so that the window keeps responding. The
+   results are published as snapshots of the trajectory that the
+   display picks up.
+
+**********************************************************************/
+
+#include "computeWorker.h"
+
+// Constructor: nothing running.
+ComputeWorker::ComputeWorker()
+    : running(false), stopRequested(false)
+{
+}
+
+// Destructor: cancels the computation and waits for the thread.
+ComputeWorker::~ComputeWorker()
+{
+    stop();
+}
+
+// Start a computation on a copy of the road: step is applied nrIter times, or
+// until cancel is called if nrIter is 0, and a snapshot of the trajectory is
+// published after each iteration. Returns false if a computation is running.
+bool ComputeWorker::start(Road &rd, const char *jobName, ComputeStep step, int nrIter)
+{
+    if (running)
+        return false;
+    if (worker.joinable())
+        worker.join(); // the previous computation is over
+    name = jobName;
+    work.copySettings(rd);
+    work.points = rd.points;
+    work.ctrlPts = rd.ctrlPts;
+    work.keyframes = rd.keyframes;
+    stopRequested = false;
+    running = true;
+    worker = thread(&ComputeWorker::run, this, rd.version, step, nrIter);
+    return true;
+}
+
+// Ask the computation to stop after the current iteration.
+void ComputeWorker::cancel()
+{
+    stopRequested = true;
+}
+
+// Cancel the computation and wait until its thread is over.
+void ComputeWorker::stop()
+{
+    cancel();
+    if (worker.joinable())
+        worker.join();
+}
+
+// Is a computation running?
+bool ComputeWorker::busy()
+{
+    return running;
+}
+
+// The latest snapshot published, or NULL if none. It doesn't change once published.
+shared_ptr<const TrajSnapshot> ComputeWorker::latest()
+{
+    return atomic_load(&snapshot);
+}
+
+// Publish the trajectory of the copy of the road.
+void ComputeWorker::publish(unsigned int version, int iteration, int total, bool done)
+{
+    shared_ptr<TrajSnapshot> snap(new TrajSnapshot);
+    snap->traj.resize(work.points.size());
+    for (unsigned int i = 0; i < work.points.size(); i++)
+        snap->traj[i] = work.points[i].traj;
+    snap->version = version;
+    snap->iteration = iteration;
+    snap->total = total;
+    snap->done = done;
+    snap->cancelled = done && stopRequested;
+    atomic_store(&snapshot, shared_ptr<const TrajSnapshot>(snap));
+}
+
+// Main function of the thread.
+void ComputeWorker::run(unsigned int version, ComputeStep step, int nrIter)
+{
+    int i;
+    for (i = 0; (nrIter == 0 || i < nrIter) && !stopRequested; i++) {
+        step(work);
+        if (nrIter == 0 || i < nrIter - 1)
+            publish(version, i + 1, nrIter, false);
+    }
+    publish(version, i, nrIter, true);
+    running = false;
+}
+
+// Copy the trajectory of a snapshot to the road if it was computed from the same
+// version of the road, and redraw the points that changed. Returns true if
+// anything changed.
+bool applySnapshot(Road &rd, const TrajSnapshot &snap)
+{
+    int n = rd.points.size(), first = n, last = 0;
+    if (snap.version != rd.version || snap.traj.size() != n)
+        return false;
+    for (int i = 0; i < n; i++)
+        if (rd.points[i].traj != snap.traj[i]) {
+            if (i < first)
+                first = i;
+            last = i + 1;
+            rd.points[i].traj = snap.traj[i];
+        }
+    if (first >= last)
+        return false;
+    // computeTrajPt marks the points it changes for drawTrajFromPoints
+    rd.computeTrajPts(first, last);
+    rd.drawTrajFromPoints();
+    return true;
+}
@@ -0,0 +1,85 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    computeWorker.h
+   Updated: October 2026
+
+   Definition of a class running the trajectory computations on a
+   thread of their own, so that the window keeps responding. The
+   results are published as snapshots of the trajectory that the
+   display picks up.
+
+**********************************************************************/
+
+#ifndef COMPUTE_WORKER_H
+#define COMPUTE_WORKER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+using namespace std;
+#include "road.h"
+
+// One iteration of a computation on the copy of the road owned by the worker.
+// It must not draw anything.
+typedef function<void(Road &)> ComputeStep;
+
+// The state of the trajectory after some iterations of a computation.
+struct TrajSnapshot {
+    vector<float> traj;   // the trajectory value of each point
+    unsigned int version; // version of the road the computation started from
+    int iteration, total; // iterations done, out of total; total is 0 if it runs until cancelled
+    bool done;            // the last snapshot of the computation
+    bool cancelled;       // the computation was stopped before the end
+};
+
+class ComputeWorker {
+public:
+    string name; // of the computation running or the last one
+
+    // Constructor: nothing running.
+    ComputeWorker();
+
+    // Destructor: cancels the computation and waits for the thread.
+    ~ComputeWorker();
+
+    // Start a computation on a copy of the road: step is applied nrIter times, or
+    // until cancel is called if nrIter is 0, and a snapshot of the trajectory is
+    // published after each iteration. Returns false if a computation is running.
+    bool start(Road &rd, const char *jobName, ComputeStep step, int nrIter);
+
+    // Ask the computation to stop after the current iteration.
+    void cancel();
+
+    // Cancel the computation and wait until its thread is over. To call before
+    // exit, which destroys the shared pool the computation may still be using.
+    void stop();
+
+    // Is a computation running?
+    bool busy();
+
+    // The latest snapshot published, or NULL if none. It doesn't change once published.
+    shared_ptr<const TrajSnapshot> latest();
+
+private:
+    Road work; // the copy of the road the computation changes
+    thread worker;
+    atomic<bool> running, stopRequested;
+    shared_ptr<const TrajSnapshot> snapshot; // only accessed with atomic_load and atomic_store
+
+    // Publish the trajectory of the copy of the road.
+    void publish(unsigned int version, int iteration, int total, bool done);
+
+    // Main function of the thread.
+    void run(unsigned int version, ComputeStep step, int nrIter);
+};
+
+// Copy the trajectory of a snapshot to the road if it was computed from the same
+// version of the road, and redraw the points that changed. Returns true if
+// anything changed.
+bool applySnapshot(Road &rd, const TrajSnapshot &snap);
+
+#endif
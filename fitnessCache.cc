@@ -0,0 +1,162 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    fitnessCache.cc
+   Updated: October 2026
+
+   Definition of a cache storing the fitness of road segments for the
+   genes that code their trajectory, shared by concurrent threads.
+
+**********************************************************************/
+
+#include <iostream>
+#include <cstring>
+#include "fitnessCache.h"
+#include "trace.h"
+#include "log.h"
+
+// Compare all the fields of the key, the genes last since two different
+// slices can have the same hash.
+bool FitnessKey::operator==(const FitnessKey &other) const
+{
+    return hash == other.hash && startKF == other.startKF && endKF == other.endKF &&
+        interm == other.interm && version == other.version && genes == other.genes;
+}
+
+// The hash of the genes already mixes well, add the segment to it.
+size_t FitnessKeyHash::operator()(const FitnessKey &key) const
+{
+    return size_t(key.hash ^ (key.startKF * 0x9E3779B97F4A7C15ULL) ^
+                  (key.endKF * 0xC2B2AE3D27D4EB4FULL));
+}
+
+// Constructor with the maximum number of entries, split between a
+// number of shards that can be accessed at the same time.
+FitnessCache::FitnessCache(int capacity, int nrShards)
+    : hitCount(0), missCount(0), evictCount(0)
+{
+    if (nrShards < 1)
+        nrShards = 1;
+    this->nrShards = nrShards;
+    shardCapacity = capacity / nrShards;
+    if (shardCapacity < 1)
+        shardCapacity = 1;
+    shards = new Shard[nrShards];
+    for (int i = 0; i < nrShards; i++) {
+        shards[i].hand = 0;
+        shards[i].entries.reserve(shardCapacity);
+    }
+}
+
+// Destructor
+FitnessCache::~FitnessCache()
+{
+    delete [] shards;
+}
+
+// Make the key for a segment from the slice of the genome coding for it.
+// The hash is a 64 bit FNV-1a of the bytes of the genes.
+FitnessKey FitnessCache::makeKey(const vector<double> &traj, int startKF, int endKF,
+                                 int interm, unsigned int version)
+{
+    FitnessKey key;
+    unsigned long long h = 14695981039346656037ULL, bits;
+    for (unsigned int i = 0; i < traj.size(); i++) {
+        memcpy(&bits, &traj[i], sizeof(bits));
+        for (int b = 0; b < 8; b++) {
+            h ^= (bits >> (8 * b)) & 0xff;
+            h *= 1099511628211ULL;
+        }
+    }
+    key.startKF = startKF;
+    key.endKF = endKF;
+    key.interm = interm;
+    key.version = version;
+    key.hash = h ^ traj.size();
+    key.genes = traj;
+    return key;
+}
+
+// Look for a segment in the cache. Returns true and the stored values if found.
+bool FitnessCache::find(const FitnessKey &key, double &dist, double &curv)
+{
+    Shard &shard = shards[FitnessKeyHash()(key) % nrShards];
+    unique_lock<mutex> guard(shard.lock);
+    unordered_map<FitnessKey, int, FitnessKeyHash>::iterator it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        missCount++;
+        return false;
+    }
+    Entry &entry = shard.entries[it->second];
+    entry.referenced = true;
+    dist = entry.dist;
+    curv = entry.curv;
+    hitCount++;
+    return true;
+}
+
+// Store the values for a segment, evicting an old one if the shard is full.
+void FitnessCache::insert(const FitnessKey &key, double dist, double curv)
+{
+    Shard &shard = shards[FitnessKeyHash()(key) % nrShards];
+    unique_lock<mutex> guard(shard.lock);
+    if (shard.index.count(key))
+        return; // another thread got there first
+    Entry entry = { key, dist, curv, false };
+    if (shard.entries.size() < shardCapacity) {
+        shard.index[key] = shard.entries.size();
+        shard.entries.push_back(entry);
+        return;
+    }
+    // clock: give a second chance to the entries used since the last round
+    while (shard.entries[shard.hand].referenced) {
+        shard.entries[shard.hand].referenced = false;
+        shard.hand = (shard.hand + 1) % shardCapacity;
+    }
+    shard.index.erase(shard.entries[shard.hand].key);
+    shard.entries[shard.hand] = entry;
+    shard.index[key] = shard.hand;
+    shard.hand = (shard.hand + 1) % shardCapacity;
+    evictCount++;
+}
+
+// Remove all the entries, but not the counters.
+void FitnessCache::clear()
+{
+    for (int i = 0; i < nrShards; i++) {
+        unique_lock<mutex> guard(shards[i].lock);
+        shards[i].index.clear();
+        shards[i].entries.clear();
+        shards[i].hand = 0;
+    }
+}
+
+// Number of lookups that found the segment.
+long FitnessCache::hits()
+{
+    return hitCount;
+}
+
+// Number of lookups that didn't find the segment.
+long FitnessCache::misses()
+{
+    return missCount;
+}
+
+// Number of entries replaced by newer ones.
+long FitnessCache::evictions()
+{
+    return evictCount;
+}
+
+// Output the counters and the hit rate.
+void FitnessCache::outputStats()
+{
+    long h = hitCount, m = missCount;
+    TRACE_COUNT("fitness cache hits", h);
+    TRACE_COUNT("fitness cache misses", m);
+    LOG(logInfo, "fitness cache hits: " << h << " misses: " << m
+         << " evictions: " << evictCount << " hit rate: "
+         << (h + m ? 100.0 * h / (h + m) : 0) << "%");
+}
@@ -0,0 +1,83 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    fitnessCache.h
+   Updated: October 2026
+
+   Definition of a cache storing the fitness of road segments for the
+   genes that code their trajectory, shared by concurrent threads.
+
+**********************************************************************/
+
+#ifndef FITNESS_CACHE_H
+#define FITNESS_CACHE_H
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+using namespace std;
+
+// A segment between two keyframes, the density of the genes, the genes
+// with their hash, and the version of the road.
+struct FitnessKey {
+    int startKF, endKF, interm;
+    unsigned int version;
+    unsigned long long hash;
+    vector<double> genes; // compared when the hashes are equal
+
+    bool operator==(const FitnessKey &other) const;
+};
+
+struct FitnessKeyHash {
+    size_t operator()(const FitnessKey &key) const;
+};
+
+class FitnessCache {
+public:
+    // Constructor with the maximum number of entries, split between a
+    // number of shards that can be accessed at the same time.
+    FitnessCache(int capacity = 100000, int nrShards = 16);
+    ~FitnessCache();
+
+    // Make the key for a segment from the slice of the genome coding for it.
+    static FitnessKey makeKey(const vector<double> &traj, int startKF, int endKF,
+                              int interm, unsigned int version);
+
+    // Look for a segment in the cache. Returns true and the stored values if found.
+    bool find(const FitnessKey &key, double &dist, double &curv);
+
+    // Store the values for a segment, evicting an old one if the shard is full.
+    void insert(const FitnessKey &key, double dist, double curv);
+
+    // Remove all the entries, but not the counters.
+    void clear();
+
+    // Counters.
+    long hits();
+    long misses();
+    long evictions();
+
+    // Output the counters and the hit rate.
+    void outputStats();
+
+private:
+    struct Entry {
+        FitnessKey key;
+        double dist, curv;
+        bool referenced; // second chance for the clock eviction
+    };
+    struct Shard {
+        mutex lock;
+        unordered_map<FitnessKey, int, FitnessKeyHash> index;
+        vector<Entry> entries;
+        int hand; // position of the clock
+    };
+
+    Shard *shards;
+    int nrShards, shardCapacity;
+    atomic<long> hitCount, missCount, evictCount;
+};
+
+#endif
@@ -0,0 +1,181 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    fleet.cc
+   Updated: October 2026
+
+   Definition of a class animating many vehicles driving along
+   trajectories, such as replayed laps or the candidates of the GA.
+
+**********************************************************************/
+
+#include <cmath>
+#include "fleet.h"
+
+// Constructor: no laps and no vehicles.
+Fleet::Fleet()
+    : Obj_container(1, 1, 64)
+{
+    maxSpeed = 80;
+    latAccel = 15;
+    accel = 8;
+    brake = 12;
+    set_color(1, 1, 0);
+    setSize(1);
+}
+
+// Add the trajectory of the road as a lap, with a speed profile limited by
+// its curvature. Returns the index of the lap, or -1 if it is too short.
+int Fleet::addLap(Road &rd)
+{
+    int n = rd.points.size(), i;
+    float ds, curv, limit;
+    if (n < 2)
+        return -1;
+    laps.push_back(Lap());
+    Lap &lap = laps.back();
+    lap.x.resize(n);
+    lap.y.resize(n);
+    lap.dist.resize(n);
+    lap.speed.resize(n);
+    for (i = 0; i < n; i++) {
+        lap.x[i] = rd.points[i].trjPt.x();
+        lap.y[i] = rd.points[i].trjPt.y();
+        lap.dist[i] = i ? lap.dist[i - 1] + rd.points[i].trjPt.distance(rd.points[i - 1].trjPt) : 0;
+    }
+    if (lap.dist[n - 1] <= 0) {
+        laps.pop_back();
+        return -1;
+    }
+
+    // the curvature limits the speed, the speed changes are limited by the
+    // acceleration going forward and by the braking going backward
+    for (i = 0; i < n; i++) {
+        lap.speed[i] = maxSpeed;
+        if (i > 0 && i < n - 1) {
+            ds = (lap.dist[i + 1] - lap.dist[i - 1]) / 2;
+            curv = ds > 0 ? fabs(rd.realTrajCurv(i)) / ds : 0;
+            if (curv > 0) {
+                limit = sqrt(latAccel / curv);
+                if (limit < lap.speed[i])
+                    lap.speed[i] = limit;
+            }
+        }
+    }
+    for (i = 1; i < n; i++) {
+        limit = sqrt(lap.speed[i - 1] * lap.speed[i - 1] +
+                     2 * accel * (lap.dist[i] - lap.dist[i - 1]));
+        if (limit < lap.speed[i])
+            lap.speed[i] = limit;
+    }
+    for (i = n - 2; i >= 0; i--) {
+        limit = sqrt(lap.speed[i + 1] * lap.speed[i + 1] +
+                     2 * brake * (lap.dist[i + 1] - lap.dist[i]));
+        if (limit < lap.speed[i])
+            lap.speed[i] = limit;
+    }
+    return laps.size() - 1;
+}
+
+// Make room for the vehicle i in the vehicle arrays.
+void Fleet::reserve(int i)
+{
+    if (i < lapNr.size())
+        return;
+    lapNr.resize(count, 0);
+    cursor.resize(count, 0);
+    along.resize(count, 0);
+    scale.resize(count, 1);
+    current.resize(count, 0);
+}
+
+// Add a vehicle on the lap lap, at the distance start from its beginning,
+// driving at speedScale times the speed profile. Returns a handle that is
+// not valid, of index -1, if there is no such lap.
+Obj_handle Fleet::addVehicle(int lap, float start, float speedScale)
+{
+    if (lap < 0 || lap >= laps.size()) {
+        Obj_handle none = {-1, 0};
+        return none;
+    }
+    Obj_handle h = activate(0, 0);
+    int i = h.index;
+    reserve(i);
+    lapNr[i] = lap;
+    cursor[i] = 0;
+    along[i] = fmod(start, laps[lap].dist.back());
+    if (along[i] < 0)
+        along[i] += laps[lap].dist.back();
+    scale[i] = speedScale;
+    place(i);
+    return h;
+}
+
+// Remove all the vehicles and laps.
+void Fleet::clearAll()
+{
+    for (int i = 0; i < count; i++)
+        kill(i);
+    laps.clear();
+}
+
+// Move the vehicle i to the position along[i] on its lap, moving the cursor
+// forward from where it was, unless the vehicle starts the lap again.
+void Fleet::place(int i)
+{
+    Lap &lap = laps[lapNr[i]];
+    int c, last = lap.dist.size() - 1;
+    float t;
+    if (along[i] >= lap.dist[last]) {
+        along[i] = fmod(along[i], lap.dist[last]);
+        cursor[i] = 0;
+    }
+    c = cursor[i];
+    while (c < last - 1 && along[i] >= lap.dist[c + 1])
+        c++;
+    cursor[i] = c;
+    t = lap.dist[c + 1] > lap.dist[c] ?
+        (along[i] - lap.dist[c]) / (lap.dist[c + 1] - lap.dist[c]) : 0;
+    posx[i] = lap.x[c] + t * (lap.x[c + 1] - lap.x[c]);
+    posy[i] = lap.y[c] + t * (lap.y[c + 1] - lap.y[c]);
+    current[i] = lap.speed[c] + t * (lap.speed[c + 1] - lap.speed[c]);
+}
+
+// Move each vehicle forward by its speed times its scale times dt. The
+// arrays don't alias, so the loop can use SIMD.
+static void moveAlong(float *__restrict along, const float *__restrict current,
+                      const float *__restrict scale, float dt, int n)
+{
+    for (int i = 0; i < n; i++)
+        along[i] += current[i] * scale[i] * dt;
+}
+
+// Move all the vehicles forward by dt seconds. They start the lap again
+// when they reach the end.
+void Fleet::advance(float dt)
+{
+    int n = lapNr.size(), i;
+    if (n == 0)
+        return;
+
+    // all the vehicles move at once
+    moveAlong(&along[0], &current[0], &scale[0], dt, n);
+
+    // then each of them catches up with its cursor, which costs O(1) per
+    // frame as long as a vehicle passes few points in a frame
+    for (i = 0; i < n; i++)
+        if (alive[i])
+            place(i);
+        else
+            current[i] = 0;
+}
+
+// Set the vehicles as squares of the given size.
+void Fleet::setSize(float size)
+{
+    float h = size / 2;
+    GLfloat square[12] = {-h, -h, h, -h, h, h, -h, -h, h, h, -h, h};
+    shape1.assign(square, square + 12);
+    shape2 = shape1;
+}
@@ -0,0 +1,74 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    fleet.h
+   Updated: October 2026
+
+   Definition of a class animating many vehicles driving along
+   trajectories, such as replayed laps or the candidates of the GA.
+
+**********************************************************************/
+
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <vector>
+using namespace std;
+#include "obj_container.h"
+#include "road.h"
+
+// A trajectory the vehicles can drive along, copied from a road.
+struct Lap {
+    vector<float> x, y;  // the trajectory points
+    vector<float> dist;  // distance from the first point, the last one is the length
+    vector<float> speed; // speed at each point
+};
+
+class Fleet : public Obj_container {
+public:
+    vector<Lap> laps;
+    // The vehicles are the objects of the container: vehicle i follows the lap
+    // lapNr[i] and is between the points cursor[i] and cursor[i] + 1 of it, at the
+    // distance along[i] from the start, driving at scale[i] times the speed there.
+    vector<int> lapNr, cursor;
+    vector<float> along, scale;
+    float maxSpeed,  // speed on straight lines
+          latAccel,  // lateral acceleration limiting the speed in the curves
+          accel,     // acceleration out of the curves
+          brake;     // deceleration before the curves
+
+    // Constructor: no laps and no vehicles.
+    Fleet();
+
+    // Add the trajectory of the road as a lap, with a speed profile limited by
+    // its curvature. Returns the index of the lap, or -1 if it is too short.
+    int addLap(Road &rd);
+
+    // Add a vehicle on the lap lap, at the distance start from its beginning,
+    // driving at speedScale times the speed profile. Returns a handle that is
+    // not valid, of index -1, if there is no such lap.
+    Obj_handle addVehicle(int lap, float start, float speedScale = 1);
+
+    // Remove all the vehicles and laps.
+    void clearAll();
+
+    // Move all the vehicles forward by dt seconds. They start the lap again
+    // when they reach the end.
+    void advance(float dt);
+
+    // Set the vehicles as squares of the given size.
+    void setSize(float size);
+
+private:
+    vector<float> current; // speed of each vehicle where it is, 0 if it is not alive
+
+    // Make room for the vehicle i in the vehicle arrays.
+    void reserve(int i);
+
+    // Move the vehicle i to the position along[i] on its lap, moving the cursor
+    // forward from where it was, unless the vehicle starts the lap again.
+    void place(int i);
+};
+
+#endif
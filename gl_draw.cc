@@ -11,7 +11,9 @@
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
 #include "gl_draw.h"
+#include "meshCache.h"
 
 // Draws a 2D box.
 void gl_box2D(int x1, int y1, int x2, int y2)
@@ -71,254 +73,224 @@ void gl_triangle_strip(const vector3f &coords1, const vector3f &coords2,
     glEnd();
 }
 
-// Translation of the DataViewer line with ribbon object.
-void gl_ribbon(const vector3f &line_coords, const vector3f &direction)
+// Arrays of at least n coordinates for the slot k, from 0 to
+// GEOM_SLOTS - 1. They are only valid until the slot is asked again.
+SoA3 GeomScratch::get(int k, int n)
 {
-    int size = line_coords.size();
-    vector3f normals1(size);
-    vector3f normals2(size);
-    vector3f normals3(size);
-    vector3f border1(size);
-    vector3f border2(size);
-    int i, j;
+    SoA3 arrays;
+    if (slots[k].size() < 3 * n)
+        slots[k].resize(3 * n);
+    arrays.x = &slots[k][0];
+    arrays.y = arrays.x + n;
+    arrays.z = arrays.y + n;
+    return arrays;
+}
+
+// The scratch of the calling thread, for the functions called without one.
+static GeomScratch &threadScratch()
+{
+    static thread_local GeomScratch scratch;
+    return scratch;
+}
+
+// Copy the points of a vector into separate coordinates.
+static void split_coords(const vector3f &coords, SoA3 &out)
+{
+    for (unsigned int i = 0; i < coords.size(); i++) {
+        out.x[i] = coords[i][0];
+        out.y[i] = coords[i][1];
+        out.z[i] = coords[i][2];
+    }
+}
+
+// Store the vertices of a triangle strip alternating between the points of
+// coords1 and coords2 with their normals in out, 6 floats per vertex.
+static GLfloat *interleave_strip(const SoA3 &coords1, const SoA3 &coords2,
+                                 const SoA3 &normals1, const SoA3 &normals2,
+                                 int size, GLfloat *out)
+{
+    for (int i = 0; i < size; i++, out += 12) {
+        out[0] = coords1.x[i];
+        out[1] = coords1.y[i];
+        out[2] = coords1.z[i];
+        out[3] = normals1.x[i];
+        out[4] = normals1.y[i];
+        out[5] = normals1.z[i];
+        out[6] = coords2.x[i];
+        out[7] = coords2.y[i];
+        out[8] = coords2.z[i];
+        out[9] = normals2.x[i];
+        out[10] = normals2.y[i];
+        out[11] = normals2.z[i];
+    }
+    return out;
+}
+
+// Draw triangle strips of count vertices each stored as in interleave_strip.
+static void draw_strips(const vector<GLfloat> &vertices, int nrStrips, int count)
+{
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), &vertices[0]);
+    glNormalPointer(GL_FLOAT, 6 * sizeof(GLfloat), &vertices[3]);
+    for (int i = 0; i < nrStrips; i++)
+        glDrawArrays(GL_TRIANGLE_STRIP, i * count, count);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Compute the vertices of the ribbon drawn by gl_ribbon in out, without
+// drawing them: two triangle strips of 2 * size vertices each, from the
+// first border to the line, then from the line to the second border, with
+// x, y, z, nx, ny, nz for every vertex. out must hold 24 * size floats.
+void ribbon_vertices(const vector3f &line_coords, const vector3f &direction,
+                     GLfloat *out, GeomScratch &scratch)
+{
+    int size = line_coords.size(), i;
+    SoA3 line = scratch.get(0, size), border1 = scratch.get(1, size),
+        border2 = scratch.get(2, size), normals1 = scratch.get(3, size),
+        normals2 = scratch.get(4, size), normals3 = scratch.get(5, size);
 
     // Compute the ribbon borders and initialize the normals to 0.
-    for (i = 0; i < size; i++)
-        for (j = 0; j < 3; j++) {
-            border1[i][j] = line_coords[i][j] + direction[i][j];
-            border2[i][j] = line_coords[i][j] - direction[i][j];
-            normals1[i][j] = 0;
-            normals2[i][j] = 0;
-            normals3[i][j] = 0;
-        }
+    split_coords(line_coords, line);
+    split_coords(direction, border2);
+    for (i = 0; i < size; i++) {
+        border1.x[i] = line.x[i] + border2.x[i];
+        border1.y[i] = line.y[i] + border2.y[i];
+        border1.z[i] = line.z[i] + border2.z[i];
+        border2.x[i] = line.x[i] - border2.x[i];
+        border2.y[i] = line.y[i] - border2.y[i];
+        border2.z[i] = line.z[i] - border2.z[i];
+    }
+    fill(normals1.x, normals1.x + 3 * size, 0);
+    fill(normals2.x, normals2.x + 3 * size, 0);
+    fill(normals3.x, normals3.x + 3 * size, 0);
 
     // Compute all of the normals and normalize them.
-    add_normals(border1, line_coords, normals1, normals2);
-    add_normals(line_coords, border2, normals2, normals3);
-    normalize_vectors(normals1);
-    normalize_vectors(normals2);
-    normalize_vectors(normals3);
+    add_normals(border1, line, normals1, normals2, size, scratch);
+    add_normals(line, border2, normals2, normals3, size, scratch);
+    normalize_vectors(normals1, size);
+    normalize_vectors(normals2, size);
+    normalize_vectors(normals3, size);
+
+    out = interleave_strip(border1, line, normals1, normals2, size, out);
+    interleave_strip(line, border2, normals2, normals3, size, out);
+}
+
+// Translation of the DataViewer line with ribbon object. Without a
+// scratch, the one of the calling thread is used.
+void gl_ribbon(const vector3f &line_coords, const vector3f &direction,
+               GeomScratch *scratch)
+{
+    static thread_local vector<GLfloat> vertices;
+    int size = line_coords.size();
+    if (size == 0)
+        return;
+    if (vertices.size() < 24 * size)
+        vertices.resize(24 * size);
+    ribbon_vertices(line_coords, direction, &vertices[0],
+                    scratch ? *scratch : threadScratch());
 
     // Draw 2 triangle strips.
-    gl_triangle_strip(border1, line_coords, normals1, normals2);
-    gl_triangle_strip(line_coords, border2, normals2, normals3);
+    draw_strips(vertices, 2, 2 * size);
 }
 
-// Draws a triangle grid from two set of coordinates.
-void gl_triangle_grid(const vector3f &coords1, const vector3f &coords2)
+// Compute the vertices of the triangle strip drawn by gl_triangle_grid in
+// out, without drawing them: 2 * size vertices alternating between the
+// two sets, with x, y, z, nx, ny, nz for every vertex. out must hold
+// 12 * size floats.
+void grid_vertices(const vector3f &coords1, const vector3f &coords2,
+                   GLfloat *out, GeomScratch &scratch)
 {
     int size = coords1.size();
-    vector3f normals1(size);
-    vector3f normals2(size);
-    int i, j;
+    SoA3 points1 = scratch.get(0, size), points2 = scratch.get(1, size),
+        normals1 = scratch.get(3, size), normals2 = scratch.get(4, size);
 
     // Initialize the normals to 0.
-    for (i = 0; i < size; i++)
-        for (j = 0; j < 3; j++) {
-            normals1[i][j] = 0;
-            normals2[i][j] = 0;
-        }
+    split_coords(coords1, points1);
+    split_coords(coords2, points2);
+    fill(normals1.x, normals1.x + 3 * size, 0);
+    fill(normals2.x, normals2.x + 3 * size, 0);
 
     // Compute all of the normals and normalize them.
-    add_normals(coords1, coords2, normals1, normals2);
-    normalize_vectors(normals1);
-    normalize_vectors(normals2);
+    add_normals(points1, points2, normals1, normals2, size, scratch);
+    normalize_vectors(normals1, size);
+    normalize_vectors(normals2, size);
+
+    interleave_strip(points1, points2, normals1, normals2, size, out);
+}
+
+// Draws a triangle grid from two set of coordinates. Without a scratch,
+// the one of the calling thread is used.
+void gl_triangle_grid(const vector3f &coords1, const vector3f &coords2,
+                      GeomScratch *scratch)
+{
+    static thread_local vector<GLfloat> vertices;
+    int size = coords1.size();
+    if (size == 0)
+        return;
+    if (vertices.size() < 12 * size)
+        vertices.resize(12 * size);
+    grid_vertices(coords1, coords2, &vertices[0], scratch ? *scratch : threadScratch());
 
     // Draw 1 triangle strips.
-    gl_triangle_strip(coords1, coords2, normals1, normals2);
+    draw_strips(vertices, 1, 2 * size);
+}
+
+// The batch of the strips of a precision, kept between the calls so that a
+// strip drawn again with the same segments is not sent to OpenGL again.
+// The batches are never deleted, their buffer objects go with the context.
+static MeshBatch &stripBatch(int precision)
+{
+    static MeshBatch *batches[3] = {NULL, NULL, NULL};
+    precision = precision < 1 ? 1 : precision > 3 ? 3 : precision;
+    if (!batches[precision - 1])
+        batches[precision - 1] = new MeshBatch(tubeMesh, precision);
+    return *batches[precision - 1];
 }
 
 // Draws a strip of cones.
 void gl_cone_strip(const vector3f &coords, float radia[], int precision)
 {
-    //static GLUquadricObj *Cone = NULL;
-    //if (!Cone)
-    //Cone = gluNewQuadric();
-    GLUquadricObj *Cone = gluNewQuadric();
-    int slices = 0, stacks = 0;
-
-    // Determine the precision of the rendering.
-    switch (precision) {
-    case 1:
-        gluQuadricDrawStyle(Cone, (GLenum)GLU_LINE);
-        slices = 10;
-        stacks = 1;
-        break;
-    case 2:
-        gluQuadricDrawStyle(Cone, (GLenum)GLU_FILL);
-        slices = 10;
-        stacks = 1;
-        break;
-    case 3:
-        gluQuadricDrawStyle(Cone, (GLenum)GLU_FILL);
-        slices = 20;
-        stacks = 2;
-        break;
-    }
+    MeshBatch &cones = stripBatch(precision);
+    cones.clear();
 
     // Enable the normals for a smooth lightning.
-    gluQuadricNormals(Cone, (GLenum)GLU_SMOOTH);
     glEnable(GL_LIGHTING);
 
-    //Draw each of the cylinders
-    for (unsigned int i = 0; i < coords.size() - 1; i++) {
-        Point3f a = coords[i];
-        Point3f b = coords[i + 1];
-        Point3f c;
-        Point3f nc;
-        Point3f axis;
-        float axis_norm, angle, c_norm;
-        int l;
-        glPushMatrix();
-        // Move the origin to a
-        for (l = 0; l < 3; l++)
-            c[l] = b[l] - a[l];
-        if (c[2] < 0) {
-            glTranslatef(b[0], b[1], b[2]);
-            for (l = 0; l < 3; l++)
-                c[l] = -c[l];
-        }
-        else
-            glTranslatef(a[0], a[1], a[2]);
-        c_norm = c.norm();
-        if (c_norm > 0.0001) {
-            // Rotate about the cross product of normalized c and (0,0,1)
-            // normalize c
-            for (int l = 0; l < 3; l++)
-                nc[l] = c[l] / c_norm;
-            // Compute cross product.  It is easy since one of the vectors
-            // is (0,0,1)
-            axis[0] = -nc[1];
-            axis[1] = nc[0];
-            axis[2] = 0;
-            axis_norm = axis.norm();
-            if (axis_norm < 0.00001)
-                angle = 0.0;
-            else
-                angle = (float)asin((float)axis_norm);
-            glRotated((angle * 360.0) / (2 * M_PI), axis[0], axis[1], axis[2]);
-            gluCylinder(Cone, radia[i], radia[i + 1],
-                c_norm, slices, stacks);
-        }
-        glPopMatrix();
-    }
-    gluDeleteQuadric(Cone);
+    // All the cones are drawn together from the cached mesh
+    for (unsigned int i = 0; i + 1 < coords.size(); i++)
+        cones.addTube(coords[i], coords[i + 1], radia[i], radia[i + 1]);
+    cones.draw();
 }
 
 // Draws a strip of cylinders.
 void gl_cylinder_strip(const vector3f &coords, float width, int precision)
 {
-    //static GLUquadricObj *Cylinder = NULL;
-    //if (!Cylinder)
-    //Cylinder = gluNewQuadric();
-    GLUquadricObj *Cylinder = gluNewQuadric();
-    int slices = 0, stacks = 0;
-
-    // Determine the precision of the rendering.
-    switch (precision) {
-    case 1:
-        gluQuadricDrawStyle(Cylinder, (GLenum)GLU_LINE);
-        slices = 10;
-        stacks = 1;
-        break;
-    case 2:
-        gluQuadricDrawStyle(Cylinder, (GLenum)GLU_FILL);
-        slices = 10;
-        stacks = 1;
-        break;
-    case 3:
-        gluQuadricDrawStyle(Cylinder, (GLenum)GLU_FILL);
-        slices = 20;
-        stacks = 2;
-        break;
-    }
+    MeshBatch &cylinders = stripBatch(precision);
+    cylinders.clear();
 
     // Enable the normals for a smooth lightning.
-    gluQuadricNormals(Cylinder, (GLenum)GLU_SMOOTH);
     glEnable(GL_LIGHTING);
 
-    //Draw each of the cylinders
-    for (unsigned int i = 0; i < coords.size() - 1; i++) {
-        Point3f a = coords[i];
-        Point3f b = coords[i + 1];
-        Point3f c;
-        Point3f nc;
-        Point3f axis;
-        float axis_norm, angle, c_norm;
-        int l;
-        glPushMatrix();
-        // Move the origin to a
-        for (l = 0; l < 3; l++)
-            c[l] = b[l] - a[l];
-        if (c[2] < 0) {
-            glTranslatef(b[0], b[1], b[2]);
-            for (l = 0; l < 3; l++)
-                c[l] = -c[l];
-        }
-        else
-            glTranslatef(a[0], a[1], a[2]);
-        c_norm = c.norm();
-        if (c_norm > 0.0001) {
-            // Rotate about the cross product of normalized c and (0,0,1)
-            // normalize c
-            for (int l = 0; l < 3; l++)
-                nc[l] = c[l] / c_norm;
-            // Compute cross product.  It is easy since one of the vectors
-            // is (0,0,1)
-            axis[0] = -nc[1];
-            axis[1] = nc[0];
-            axis[2] = 0;
-            axis_norm = axis.norm();
-            if (axis_norm < 0.00001)
-                angle = 0.0;
-            else
-                angle = (float)asin((float)axis_norm);
-            glRotated((angle * 360.0) / (2 * M_PI), axis[0], axis[1], axis[2]);
-            gluCylinder(Cylinder, width, width,
-                c_norm, slices, stacks);
-        }
-        glPopMatrix();
-    }
-    gluDeleteQuadric(Cylinder);
+    // All the cylinders are drawn together from the cached mesh
+    for (unsigned int i = 0; i + 1 < coords.size(); i++)
+        cylinders.addTube(coords[i], coords[i + 1], width, width);
+    cylinders.draw();
 }
 
 // Draws one sphere with specified coordinates and axes.
 void gl_sphere(GLfloat center_x, GLfloat center_y, GLfloat center_z,
     GLfloat radius, int precision)
 {
-    //static GLUquadricObj *Sphere = NULL;
-    //if (Sphere == NULL)
-    //Sphere = gluNewQuadric();
-    GLUquadricObj *Sphere = gluNewQuadric();
-    int slices = 0, stacks = 0;
-
-    // Determine the precision of the rendering.
-    switch (precision) {
-    case 1:
-        gluQuadricDrawStyle(Sphere, (GLenum)GLU_LINE);
-        slices = 10;
-        stacks = 10;
-        break;
-    case 2:
-        gluQuadricDrawStyle(Sphere, (GLenum)GLU_FILL);
-        slices = 10;
-        stacks = 10;
-        break;
-    case 3:
-        gluQuadricDrawStyle(Sphere, (GLenum)GLU_FILL);
-        slices = 20;
-        stacks = 20;
-        break;
-    }
     // Enable the normals for a smooth lightning.
-    gluQuadricNormals(Sphere, (GLenum)GLU_SMOOTH);
     glEnable(GL_LIGHTING);
 
     glPushMatrix();
     glTranslatef(center_x, center_y, center_z);
-    gluSphere(Sphere, radius, slices, stacks);
+    glScalef(radius, radius, radius);
+    drawMesh(getMesh(sphereMesh, precision));
     glPopMatrix();
-    gluDeleteQuadric(Sphere);
 }
 
 // Draws one ellipsoid with specified coordinates and axes.
@@ -326,41 +298,14 @@ void gl_ellipsoid(GLfloat center_x, GLfloat center_y, GLfloat center_z,
     GLfloat axis_x, GLfloat axis_y, GLfloat axis_z,
     int precision)
 {
-    //static GLUquadricObj *Sphere = NULL;
-    //if (Sphere == NULL)
-    //Sphere = gluNewQuadric();
-    GLUquadricObj *Sphere = gluNewQuadric();
-    int slices = 0, stacks = 0;
-
-    // Determine the precision of the rendering.
-    switch (precision) {
-    case 1:
-        gluQuadricDrawStyle(Sphere, (GLenum)GLU_LINE);
-        slices = 10;
-        stacks = 10;
-        break;
-    case 2:
-        gluQuadricDrawStyle(Sphere, (GLenum)GLU_FILL);
-        slices = 10;
-        stacks = 10;
-        break;
-    case 3:
-        gluQuadricDrawStyle(Sphere, (GLenum)GLU_FILL);
-        slices = 20;
-        stacks = 20;
-        break;
-    }
-
     // Enable the normals for a smooth lightning.
-    gluQuadricNormals(Sphere, (GLenum)GLU_SMOOTH);
     glEnable(GL_LIGHTING);
 
     glPushMatrix();
     glTranslatef(center_x, center_y, center_z);
     glScalef(axis_x, axis_y, axis_z);
-    gluSphere(Sphere, 1.0, slices, stacks);
+    drawMesh(getMesh(sphereMesh, precision));
     glPopMatrix();
-    gluDeleteQuadric(Sphere);
 }
 
 // Mirror the vectors over the z axis.
@@ -401,6 +346,69 @@ void add_normals(const vector3f &coords1, const vector3f &coords2,
     }
 }
 
+// Normal of the plane of the points 0, 1, 2 for each index as in
+// compute_normal_vector. The coordinates come as separate arrays that don't
+// alias the output, so the loop can use SIMD.
+static void face_normals(const GLfloat *__restrict x0, const GLfloat *__restrict y0,
+                         const GLfloat *__restrict z0, const GLfloat *__restrict x1,
+                         const GLfloat *__restrict y1, const GLfloat *__restrict z1,
+                         const GLfloat *__restrict x2, const GLfloat *__restrict y2,
+                         const GLfloat *__restrict z2, GLfloat *__restrict outX,
+                         GLfloat *__restrict outY, GLfloat *__restrict outZ, int count)
+{
+    for (int i = 0; i < count; i++) {
+        float d1x = x0[i] - x1[i], d1y = y0[i] - y1[i], d1z = z0[i] - z1[i];
+        float d2x = x1[i] - x2[i], d2y = y1[i] - y2[i], d2z = z1[i] - z2[i];
+        float nx = d1y * d2z - d1z * d2y, ny = d1z * d2x - d1x * d2z, nz = d1x * d2y - d1y * d2x;
+        float d = sqrtf(nx * nx + ny * ny + nz * nz);
+        d += (d == 0); // a zero vector stays as it is
+        outX[i] = nx / d;
+        outY[i] = ny / d;
+        outZ[i] = nz / d;
+    }
+}
+
+// Same for the points at the offsets off0, off1, off2 of the arrays, the
+// normals being stored at the next index in out.
+static void face_normals(const SoA3 &p0, int off0, const SoA3 &p1, int off1,
+                         const SoA3 &p2, int off2, int count, SoA3 &out)
+{
+    face_normals(p0.x + off0, p0.y + off0, p0.z + off0, p1.x + off1, p1.y + off1, p1.z + off1,
+                 p2.x + off2, p2.y + off2, p2.z + off2, out.x + 1, out.y + 1, out.z + 1, count);
+}
+
+// Add to one coordinate of the normals of both sides the normals of the
+// triangles around each point, upper and lower being those of add_normals.
+static void sum_normals(const GLfloat *__restrict upper, const GLfloat *__restrict lower,
+                        GLfloat *__restrict normals1, GLfloat *__restrict normals2, int size)
+{
+    for (int i = 0; i < size; i++) {
+        normals1[i] = normals1[i] + upper[i] + lower[i] + upper[i + 1];
+        normals2[i] = normals2[i] + lower[i] + upper[i + 1] + lower[i + 1];
+    }
+}
+
+// Same as add_normals for the points 0 to size - 1 stored as separate
+// coordinates, in batched loops. The normals are added in the same order,
+// so the results are the same.
+void add_normals(const SoA3 &coords1, const SoA3 &coords2,
+                 SoA3 &normals1, SoA3 &normals2, int size, GeomScratch &scratch)
+{
+    // The normals of the two triangles of the quad i are stored at i + 1,
+    // with zeros before the first quad and after the last one.
+    SoA3 upper = scratch.get(6, size + 1), lower = scratch.get(7, size + 1);
+    if (size < 2)
+        return;
+    upper.x[0] = upper.y[0] = upper.z[0] = lower.x[0] = lower.y[0] = lower.z[0] = 0;
+    upper.x[size] = upper.y[size] = upper.z[size] = 0;
+    lower.x[size] = lower.y[size] = lower.z[size] = 0;
+    face_normals(coords1, 0, coords2, 0, coords1, 1, size - 1, upper);
+    face_normals(coords1, 1, coords2, 0, coords2, 1, size - 1, lower);
+    sum_normals(upper.x, lower.x, normals1.x, normals2.x, size);
+    sum_normals(upper.y, lower.y, normals1.y, normals2.y, size);
+    sum_normals(upper.z, lower.z, normals1.z, normals2.z, size);
+}
+
 // Normalizes each vector in the array.
 void normalize_vectors(Point3f normals[], int size)
 {
@@ -415,6 +423,25 @@ void normalize_vectors(vector3f &normals)
         normals[i].normalize();
 }
 
+// Normalizes the vectors 0 to size - 1 stored in separate arrays.
+static void normalize_vectors(GLfloat *__restrict x, GLfloat *__restrict y,
+                              GLfloat *__restrict z, int size)
+{
+    for (int i = 0; i < size; i++) {
+        float d = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        d += (d == 0); // a zero vector stays as it is
+        x[i] /= d;
+        y[i] /= d;
+        z[i] /= d;
+    }
+}
+
+// Normalizes the vectors 0 to size - 1 stored as separate coordinates.
+void normalize_vectors(SoA3 &normals, int size)
+{
+    normalize_vectors(normals.x, normals.y, normals.z, size);
+}
+
 // Normalizes each vector in the matrix.
 void normalize_vectors(matrix3f &normals)
 {
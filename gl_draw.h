@@ -16,6 +16,26 @@
 #include "point2d.h"
 
 #define M_PI 3.141592
+#define GEOM_SLOTS 8 // arrays of 3 coordinates in a GeomScratch
+
+// Three coordinates of a set of points or vectors, each in its own
+// contiguous array, so that the loops over them can use SIMD.
+struct SoA3 {
+    GLfloat *x, *y, *z;
+};
+
+// Reusable arrays for the geometry builders. They only grow, so keeping
+// one between calls makes the builders allocation-free. A scratch must
+// not be used by two threads at the same time.
+class GeomScratch {
+public:
+    // Arrays of at least n coordinates for the slot k, from 0 to
+    // GEOM_SLOTS - 1. They are only valid until the slot is asked again.
+    SoA3 get(int k, int n);
+
+private:
+    vector<GLfloat> slots[GEOM_SLOTS];
+};
 
 // Draws a 2D box.
 void gl_box2D(int x1, int y1, int x2, int y2);
@@ -33,11 +53,29 @@ void gl_triangle_strip(const vector3f &coords, const vector3f &normals);
 void gl_triangle_strip(const vector3f &coords1, const vector3f &coords2, 
 		       const vector3f &normals1, const vector3f &normals2);
 
-// Draws a triangle grid from two set of coordinates.
-void gl_triangle_grid(const vector3f &coords1, const vector3f &coords2);
-
-// Translation of the DataViewer line with ribbon object.
-void gl_ribbon(const vector3f &line_coords, const vector3f &direction);
+// Draws a triangle grid from two set of coordinates. Without a scratch,
+// the one of the calling thread is used.
+void gl_triangle_grid(const vector3f &coords1, const vector3f &coords2,
+                      GeomScratch *scratch = NULL);
+
+// Translation of the DataViewer line with ribbon object. Without a
+// scratch, the one of the calling thread is used.
+void gl_ribbon(const vector3f &line_coords, const vector3f &direction,
+               GeomScratch *scratch = NULL);
+
+// Compute the vertices of the ribbon drawn by gl_ribbon in out, without
+// drawing them: two triangle strips of 2 * size vertices each, from the
+// first border to the line, then from the line to the second border, with
+// x, y, z, nx, ny, nz for every vertex. out must hold 24 * size floats.
+void ribbon_vertices(const vector3f &line_coords, const vector3f &direction,
+                     GLfloat *out, GeomScratch &scratch);
+
+// Compute the vertices of the triangle strip drawn by gl_triangle_grid in
+// out, without drawing them: 2 * size vertices alternating between the
+// two sets, with x, y, z, nx, ny, nz for every vertex. out must hold
+// 12 * size floats.
+void grid_vertices(const vector3f &coords1, const vector3f &coords2,
+                   GLfloat *out, GeomScratch &scratch);
 
 // Draws a strip of cylinders.
 void gl_cylinder_strip(const vector3f &coords, float width, int precision);
@@ -67,9 +105,18 @@ void mirror_z(const vector3f &coord, vector3f &coord1);
 void add_normals(const vector3f &coords1, const vector3f &coords2, 
 		 vector3f &normals1, vector3f &normals2);
 
+// Same as add_normals for the points 0 to size - 1 stored as separate
+// coordinates, in batched loops. The normals are added in the same order,
+// so the results are the same.
+void add_normals(const SoA3 &coords1, const SoA3 &coords2,
+                 SoA3 &normals1, SoA3 &normals2, int size, GeomScratch &scratch);
+
 // Normalizes each vector in the array.
 void normalize_vectors(Point3f normals[], int size);
 
+// Normalizes the vectors 0 to size - 1 stored as separate coordinates.
+void normalize_vectors(SoA3 &normals, int size);
+
 // Normalizes each vector in the array.
 void normalize_vectors(vector3f &normals);
 
@@ -11,12 +11,36 @@
 
 #include <GL/glut.h>
 #include <cstdlib>
+#include <cstdio>
+#include <chrono>
 #include "road.h"
 #include "interface.h"
+#include "view.h"
+#include "trajDP.h"
+#include "segments.h"
+#include "trajColor.h"
+#include "softRender.h"
+#include "computeWorker.h"
+#include "fleet.h"
+#include "trajHistory.h"
+#include "log.h"
 
 Road *rd = NULL;
 bool timer_on = false;
+bool ticking = false; // the timer is running, for the animation or a computation
+ComputeWorker worker; // runs the trajectory computations out of the GLUT thread
+shared_ptr<const TrajSnapshot> shown; // the last snapshot of the worker drawn
+Fleet fleet; // vehicles driving along copies of the trajectory
+TrajHistory history; // the changes of the trajectory that can be undone
 int winWidth = 1200, winHeight = 900;
+Point3f viewMin, viewMax; // the area of the plane shown in the window
+Point3f fullMin, fullMax; // the view showing the whole road
+int dragX = -1, dragY = -1; // last position of the mouse while dragging the view
+
+#define WHEEL_UP 3   // the mouse wheel comes as buttons 3 and 4 in freeglut
+#define WHEEL_DOWN 4
+#define NEW_VEHICLES 1000 // vehicles added on the trajectory by the key v
+#define FRAME_TIME 16     // milliseconds between frames while the vehicles drive
 char roadFile[100] = ROAD_FILE_ROOT"trajectory21/ALpine2center.txt";
 //char roadFile[100] = ROAD_FILE_ROOT"curvature/curvALpine2R.txt";
 char trajFile[100] = "";// ROAD_FILE_ROOT"trajectory18/trajGlbsEtrack5.txt";
@@ -33,6 +57,7 @@ void glMainInit(int argc, char **argv)
     glutKeyboardFunc(key);
     glutSpecialFunc(spkey);
     glutMouseFunc(mouse);
+    glutMotionFunc(motion);
     createObjects();
     myinit();
     glutMainLoop();
@@ -41,47 +66,154 @@ void glMainInit(int argc, char **argv)
 // Displays the window
 void display(void)
 {
+    showLatest();
     glClear(GL_COLOR_BUFFER_BIT);
-    rd->display();
+    rd->display(viewMin, viewMax, (viewMax.x() - viewMin.x()) / winWidth);
+    if (fleet.nr_alive) {
+        fleet.setSize(4 * (viewMax.x() - viewMin.x()) / winWidth);
+        fleet.display();
+    }
     glFlush();
     glutSwapBuffers();
 }
 
+// Copy the latest trajectory computed by the worker to the road. When the
+// computation is done, its changes are recorded in the history.
+void showLatest()
+{
+    shared_ptr<const TrajSnapshot> snap = worker.latest();
+    if (snap && snap != shown) {
+        applySnapshot(*rd, *snap);
+        shown = snap;
+        if (snap->done) {
+            LOG(logInfo, worker.name << (snap->cancelled ? " stopped" : " done") << " after "
+                 << snap->iteration << " iterations");
+            history.record(*rd, worker.name);
+        }
+    }
+}
+
+// Undo the last change of the trajectory, or redo the last one undone.
+void undoRedo(bool redo)
+{
+    if (worker.busy()) {
+        LOG(logInfo, "Still running " << worker.name << ", press Esc to stop it");
+        return;
+    }
+    showLatest();
+    string name = redo ? history.redoName() : history.undoName();
+    if (redo ? history.redo(*rd) : history.undo(*rd)) {
+        LOG(logInfo, (redo ? "Redid " : "Undid ") << name << ", history of "
+            << history.memory() << " bytes");
+        glutPostRedisplay();
+    }
+    else
+        LOG(logInfo, "Nothing to " << (redo ? "redo" : "undo"));
+}
+
 // Advance to the next frame, update everything
 void nextFrame()
 {
+    static chrono::steady_clock::time_point last = chrono::steady_clock::now();
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    float dt = chrono::duration<float>(now - last).count();
+    last = now;
+    // the vehicles drive in real time, but don't jump after a pause
+    fleet.advance(dt < 0.1 ? dt : 0.1);
+
+    char title[100] = "Road Visualizer";
+    shared_ptr<const TrajSnapshot> snap = worker.latest();
+    if (worker.busy() && snap) {
+        if (snap->total)
+            sprintf(title, "Road Visualizer - %s %d/%d", worker.name.c_str(), 
+                    snap->iteration, snap->total);
+        else
+            sprintf(title, "Road Visualizer - %s %d", worker.name.c_str(), snap->iteration);
+    }
+    glutSetWindowTitle(title);
     glutPostRedisplay();
 }
 
-// Callback for the mouse function
+// Start a computation on the worker and the timer showing its progress.
+// Returns false if the worker is still busy with another one.
+bool startJob(const char *name, ComputeStep step, int nrIter)
+{
+    if (!worker.start(*rd, name, step, nrIter)) {
+        LOG(logInfo, "Still running " << worker.name << ", press Esc to stop it");
+        return false;
+    }
+    startTimer();
+    return true;
+}
+
+// Start the timer if it isn't running already.
+void startTimer()
+{
+    if (!ticking) {
+        ticking = true;
+        glutTimerFunc(120, timer, 0);
+    }
+}
+
+// Callback for the mouse function: the wheel zooms around the mouse, and
+// dragging with the left button moves the view.
 void mouse(int btn, int state, int x, int y)
 {
+    if (btn == WHEEL_UP || btn == WHEEL_DOWN) {
+        if (state == GLUT_DOWN)
+            zoomView(btn == WHEEL_UP ? 0.8 : 1.25, x, y);
+        return;
+    }
+    if (btn == GLUT_LEFT_BUTTON) {
+        if (state == GLUT_DOWN) {
+            dragX = x;
+            dragY = y;
+        }
+        else
+            dragX = -1;
+    }
     if (state != GLUT_DOWN)
         nextFrame();
 }
 
+// Callback for the mouse moving with a button pressed
+void motion(int x, int y)
+{
+    if (dragX < 0)
+        return;
+    panView(x - dragX, y - dragY);
+    dragX = x;
+    dragY = y;
+}
+
 // Callback for Ascii keyboard function
 void key(unsigned char key, int x, int y)
 {
     char trj[] = "traj.txt";
     char rtrj[] = "realTraj.txt";
+    char png[] = "roadviz.png";
     switch (key) {
     case 'q':
     case 'Q':
+        worker.stop();
         exit(0);
+    case 27: // Esc
+        timer_on = false;
+        worker.cancel();
+        break;
     case 'a':
     case 'A':
-        if (!timer_on) {
-            timer_on = true;
-            timer(1);
-        }
-        else
+        // optimize until stopped, showing each iteration
+        if (!timer_on)
+            timer_on = startJob("animation", [](Road &work) { work.optimizeTraj(false); }, 0);
+        else {
             timer_on = false;
+            worker.cancel();
+        }
         break;
     case 's':
     case 'S':
-        rd->smoothTrajectory(10);
-        glutPostRedisplay();
+        startJob("smoothing", [](Road &work) { work.smoothTrajectory(10, false); }, 1);
         break;
     case 'w':
     case 'W':
@@ -92,82 +224,190 @@ void key(unsigned char key, int x, int y)
         rd->writeRealPts(rtrj);
         break;
     case ' ':
-        rd->optimizeTraj();
+        startJob("optimization", [](Road &work) { work.optimizeTraj(false); }, 1);
+        break;
+    case 'g':
+    case 'G':
+        startJob("grid optimization", [](Road &work) {
+            TrajDP dp;
+            dp.optimize(work, false);
+        }, 1);
+        break;
+    case 'c':
+    case 'C':
+        rd->setColorMode(TrajColorMode((rd->colorMode + 1) % nrColorModes));
+        LOG(logInfo, "Trajectory colored by " << colorModeName(rd->colorMode));
         glutPostRedisplay();
         break;
+    case 'k':
+    case 'K':
+        rd->showMarkers = !rd->showMarkers;
+        glutPostRedisplay();
+        break;
+    case 'v': {
+        // a replay of the current trajectory: vehicles spread along it, each
+        // one a bit faster or slower than the speed profile
+        int lap = fleet.addLap(*rd);
+        if (lap < 0)
+            break;
+        for (int i = 0; i < NEW_VEHICLES; i++)
+            fleet.addVehicle(lap, fleet.laps[lap].dist.back() * i / NEW_VEHICLES,
+                             0.8 + 0.4 * rand() / RAND_MAX);
+        LOG(logInfo, fleet.nr_alive << " vehicles on " << fleet.laps.size() << " laps");
+        startTimer();
+        break;
+    }
+    case 'V':
+        fleet.clearAll();
+        glutPostRedisplay();
+        break;
+    case 'p':
+    case 'P': {
+        // the same picture as in the window, drawn without OpenGL
+        SoftRender picture(winWidth, winHeight);
+        picture.viewMin = viewMin;
+        picture.viewMax = viewMax;
+        picture.drawRoad(*rd);
+        if (fleet.nr_alive) {
+            VertexBuffer vehicles(GL_TRIANGLES);
+            fleet.setSize(4 * (viewMax.x() - viewMin.x()) / winWidth);
+            fleet.fill_shapes(vehicles);
+            picture.draw(vehicles);
+        }
+        if (picture.write(png))
+            LOG(logInfo, "Saved the picture in " << png);
+        break;
+    }
+    case 'l':
+    case 'L':
+        startJob("multi-level optimization", [](Road &work) {
+            work.multiLevelTraj(5, 20, 1, 10, false);
+        }, 1);
+        break;
+    case 'o':
+    case 'O':
+        startJob("segment optimization", [](Road &work) {
+            optimizeSegments(work, optimizeEngine(10), sharedPool(), 10, false);
+        }, 1);
+        break;
+    case 'm':
+    case 'M':
+        startJob("minimum curvature", [](Road &work) { work.minCurvTraj(30, false); }, 1);
+        break;
+    case 'u':
+    case 'U':
+        undoRedo(false);
+        break;
+    case 'r':
+    case 'R':
+        undoRedo(true);
+        break;
     }
 }
 
-// Callback for special keys keyboard function
+// Callback for special keys keyboard function: the arrows move the view,
+// page up and down zoom, and home shows the whole road again.
 void spkey(int key, int x, int y)
 {
     switch (key) {
     case GLUT_KEY_LEFT:
-        glutPostRedisplay();
+        panView(winWidth / 10, 0);
         break;
     case GLUT_KEY_RIGHT:
+        panView(-winWidth / 10, 0);
+        break;
+    case GLUT_KEY_UP:
+        panView(0, winHeight / 10);
+        break;
+    case GLUT_KEY_DOWN:
+        panView(0, -winHeight / 10);
+        break;
+    case GLUT_KEY_PAGE_UP:
+        zoomView(0.8, winWidth / 2, winHeight / 2);
+        break;
+    case GLUT_KEY_PAGE_DOWN:
+        zoomView(1.25, winWidth / 2, winHeight / 2);
+        break;
+    case GLUT_KEY_HOME:
+        viewMin = fullMin;
+        viewMax = fullMax;
+        setProjection();
         glutPostRedisplay();
         break;
     }
 }
 
-// Timer function: update everything and restart the timer
+// Timer function: update everything and restart the timer as long as the
+// animation is on, the worker is busy, or vehicles are driving
 GLvoid timer(int value)
 {
-    if (timer_on) {
-        nextFrame();
-        glutPostRedisplay();
+    nextFrame();
+    if (fleet.nr_alive)
+        glutTimerFunc(FRAME_TIME, timer, value);
+    else if (timer_on || worker.busy())
         glutTimerFunc(120, timer, value);
-    }
+    else
+        ticking = false;
 }
 
-// Set the view on the coordinate i so that we can see the whole area.
-void setView(Point3f &vMin, Point3f &vMax, int i)
+// Set the projection to the current view.
+void setProjection()
 {
-    if (vMin[i] == vMax[i])
-    {
-        vMin[i] = 0;
-        vMax[i] = 1;
-    }
-    else if (fabs(vMin[i]) < fabs(vMax[i]))
-    {
-        vMax[i] *= 1.1;
-        vMin[i] -= 0.09091 * vMax[i];
-    }
-    else
-    {
-        vMin[i] *= 1.1;
-        vMax[i] -= 0.09091 * vMin[i];
-    }
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(viewMin.x(), viewMax.x(), viewMin.y(), viewMax.y());
+    glMatrixMode(GL_MODELVIEW);
+}
+
+// Zoom the view by a factor, keeping the point at the position (x, y) in the
+// window in place. A factor smaller than 1 zooms in.
+void zoomView(float factor, int x, int y)
+{
+    float cx = viewMin.x() + (viewMax.x() - viewMin.x()) * x / winWidth,
+          cy = viewMax.y() - (viewMax.y() - viewMin.y()) * y / winHeight;
+    viewMin[0] = cx + (viewMin.x() - cx) * factor;
+    viewMax[0] = cx + (viewMax.x() - cx) * factor;
+    viewMin[1] = cy + (viewMin.y() - cy) * factor;
+    viewMax[1] = cy + (viewMax.y() - cy) * factor;
+    setProjection();
+    glutPostRedisplay();
+}
+
+// Move the view so that the road moves by (dx, dy) pixels in the window.
+void panView(int dx, int dy)
+{
+    float sx = (viewMax.x() - viewMin.x()) * dx / winWidth,
+          sy = (viewMax.y() - viewMin.y()) * dy / winHeight;
+    viewMin[0] -= sx;
+    viewMax[0] -= sx;
+    viewMin[1] += sy; // the rows of the window go down
+    viewMax[1] += sy;
+    setProjection();
+    glutPostRedisplay();
 }
 
 // Initialize the view and the road 
 void myinit()
 {
-    Point3f viewMin, viewMax;
-    float viewW = 2610, viewH = 3070;
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
     if (rd)
     {
-        viewMin = rd->min;
-        viewMax = rd->max;
-        setView(viewMin, viewMax, 0); // set x
-        setView(viewMin, viewMax, 1); // set y
-        cout << "viewMin: " << viewMin << " viewMax: " << viewMax << endl;
-        gluOrtho2D(viewMin.x(), viewMax.x(), viewMin.y(), viewMax.y());
-        viewW = viewMax.x() - viewMin.x();
-        viewH = viewMax.y() - viewMin.y();
+        fullMin = rd->min;
+        fullMax = rd->max;
+        setView(fullMin, fullMax, 0); // set x
+        setView(fullMin, fullMax, 1); // set y
+        LOG(logInfo, "viewMin: " << fullMin << " viewMax: " << fullMax);
     }
     else
-        gluOrtho2D(-90, 2700, -2700, 370);
+    {
+        fullMin.set_data(-90, -2700, 0);
+        fullMax.set_data(2700, 370, 0);
+    }
+    viewMin = fullMin;
+    viewMax = fullMax;
+    setProjection();
     
-    if (viewW / viewH > float(winWidth) / winHeight) // the view is larger than the window
-        winHeight = winWidth * (viewH / viewW);
-    else
-        winWidth = winHeight * (viewW / viewH);
+    fitWindow(viewMax.x() - viewMin.x(), viewMax.y() - viewMin.y(), winWidth, winHeight);
     glutReshapeWindow(winWidth, winHeight);
-    glMatrixMode(GL_MODELVIEW);
     glClearColor(0, 0, 0, 1.0);
     glColor3f(1.0, 0.0, 0.0);
 }
@@ -192,5 +432,6 @@ void createObjects()
         rd->readTrajFile(trajFile);
     else
         rd->setConstTraj(); // set all to 0
+    history.reset(*rd);
 }
 
@@ -13,6 +13,7 @@
 #define INTERFACE_H
 
 #include <GL/glut.h>
+#include "computeWorker.h"
 
 #define ROAD_FILE_ROOT "D:/develop/meep/data/"
 
@@ -22,23 +23,50 @@ void glMainInit(int argc, char **argv);
 // Displays the window
 void display(void);
 
+// Copy the latest trajectory computed by the worker to the road. When the
+// computation is done, its changes are recorded in the history.
+void showLatest();
+
+// Undo the last change of the trajectory, or redo the last one undone.
+void undoRedo(bool redo);
+
 // Advance to the next frame, update everything
 void nextFrame();
 
-// Callback for the mouse function
+// Start a computation on the worker and the timer showing its progress.
+// Returns false if the worker is still busy with another one.
+bool startJob(const char *name, ComputeStep step, int nrIter);
+
+// Start the timer if it isn't running already.
+void startTimer();
+
+// Callback for the mouse function: the wheel zooms around the mouse, and
+// dragging with the left button moves the view.
 void mouse(int btn, int state, int x, int y);
 
+// Callback for the mouse moving with a button pressed
+void motion(int x, int y);
+
 // Callback for Ascii keyboard function
 void key(unsigned char key, int x, int y);
 
-// Callback for special keys keyboard function
+// Callback for special keys keyboard function: the arrows move the view,
+// page up and down zoom, and home shows the whole road again.
 void spkey(int key, int x, int y);
 
-// Timer function: update everything and restart the timer
+// Timer function: update everything and restart the timer as long as the
+// animation is on, the worker is busy, or vehicles are driving
 GLvoid timer(int value);
 
-// Set the view on the coordinate i so that we can see the whole area.
-void setView(Point3f &vMin, Point3f &vMax, int i);
+// Set the projection to the current view.
+void setProjection();
+
+// Zoom the view by a factor, keeping the point at the position (x, y) in the
+// window in place. A factor smaller than 1 zooms in.
+void zoomView(float factor, int x, int y);
+
+// Move the view so that the road moves by (dx, dy) pixels in the window.
+void panView(int dx, int dy);
 
 // Initialize the view and the road 
 void myinit();
@@ -0,0 +1,225 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    lodStrip.cc
+   Updated: October 2026
+
+   Definition of a class drawing a long strip of vertices with levels
+   of detail: the strip is split into chunks with a bounding box, the
+   chunks out of the view are skipped, and the others are drawn from a
+   decimated copy of the strip matching the size of a pixel.
+
+**********************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include "lodStrip.h"
+#include "trace.h"
+
+// Constructor: nothing to draw.
+LodStrip::LodStrip()
+{
+    base = NULL;
+    perPoint = 1;
+    nrPoints = 0;
+    drawnVertices = 0;
+}
+
+// Copies are empty; they have to be built from their own buffer.
+LodStrip::LodStrip(const LodStrip &)
+{
+    base = NULL;
+    perPoint = 1;
+    nrPoints = 0;
+    drawnVertices = 0;
+}
+
+// Copies are empty; they have to be built from their own buffer.
+LodStrip &LodStrip::operator=(const LodStrip &other)
+{
+    if (this != &other)
+        clear();
+    return *this;
+}
+
+// Number of points in the level l, 0 being the base.
+int LodStrip::levelSize(int l)
+{
+    int step = 1 << l, n;
+    if (l == 0 || nrPoints == 0)
+        return nrPoints;
+    n = (nrPoints - 1) / step + 1;
+    if ((nrPoints - 1) % step) // the last point is always kept
+        n++;
+    return n;
+}
+
+// Copy the point i of the base to the level l if it has one.
+void LodStrip::copyPoint(int i, int l)
+{
+    int step = 1 << l, j, size = perPoint * VB_STRIDE;
+    if (i % step == 0)
+        j = i / step;
+    else if (i == nrPoints - 1)
+        j = levelSize(l) - 1;
+    else
+        return;
+    copy(base->data.begin() + i * size, base->data.begin() + (i + 1) * size,
+         levels[l - 1].data.begin() + j * size);
+}
+
+// Compute the box and spacing of the chunk k from the base.
+void LodStrip::computeChunk(int k)
+{
+    Chunk &chunk = chunks[k];
+    int first = k * LOD_CHUNK, last = (k + 1) * LOD_CHUNK, i, v;
+    float x, y, prevX = 0, prevY = 0, length = 0;
+    GLfloat *vertex;
+    if (last > nrPoints - 1)
+        last = nrPoints - 1;
+    vertex = &base->data[first * perPoint * VB_STRIDE];
+    chunk.xMin = chunk.xMax = vertex[0];
+    chunk.yMin = chunk.yMax = vertex[1];
+    for (i = first; i <= last; i++) {
+        // the point is the center of its vertices
+        x = y = 0;
+        for (v = 0; v < perPoint; v++) {
+            vertex = &base->data[(i * perPoint + v) * VB_STRIDE];
+            if (vertex[0] < chunk.xMin)
+                chunk.xMin = vertex[0];
+            if (vertex[0] > chunk.xMax)
+                chunk.xMax = vertex[0];
+            if (vertex[1] < chunk.yMin)
+                chunk.yMin = vertex[1];
+            if (vertex[1] > chunk.yMax)
+                chunk.yMax = vertex[1];
+            x += vertex[0];
+            y += vertex[1];
+        }
+        x /= perPoint;
+        y /= perPoint;
+        if (i > first)
+            length += sqrt((x - prevX) * (x - prevX) + (y - prevY) * (y - prevY));
+        prevX = x;
+        prevY = y;
+    }
+    chunk.spacing = last > first ? length / (last - first) : 0;
+}
+
+// Build the coarser levels and the chunks from the vertices of base, which
+// is the finest level and must stay alive. The road points are made of
+// perPoint vertices: 1 for a line, 2 for a ribbon.
+void LodStrip::build(VertexBuffer &base, int perPoint)
+{
+    TRACE_SCOPE("LodStrip::build");
+    int nrLevels = 0, i, l, nrChunks;
+    this->base = &base;
+    this->perPoint = perPoint;
+    nrPoints = base.size() / perPoint;
+
+    // coarser levels as long as they still have points inside a chunk
+    while (nrLevels < LOD_LEVELS && (2 << nrLevels) < nrPoints)
+        nrLevels++;
+    levels.assign(nrLevels, VertexBuffer(base.mode));
+    for (l = 1; l <= nrLevels; l++) {
+        levels[l - 1].data.resize(levelSize(l) * perPoint * VB_STRIDE);
+        for (i = 0; i < nrPoints; i += 1 << l)
+            copyPoint(i, l);
+        copyPoint(nrPoints - 1, l);
+        levels[l - 1].upload();
+    }
+
+    nrChunks = nrPoints > 1 ? (nrPoints - 2) / LOD_CHUNK + 1 : nrPoints;
+    chunks.resize(nrChunks);
+    for (i = 0; i < nrChunks; i++)
+        computeChunk(i);
+}
+
+// Remove the levels, so that draw doesn't do anything until the next build.
+void LodStrip::clear()
+{
+    base = NULL;
+    nrPoints = 0;
+    levels.clear();
+    chunks.clear();
+}
+
+// The vertices from first to last, not included, changed in the base buffer:
+// update them in the coarser levels and the boxes of their chunks.
+void LodStrip::update(int first, int last)
+{
+    int pFirst, pLast, step, lo, hi, j, k;
+    if (!base || first >= last)
+        return;
+    if (base->size() != nrPoints * perPoint) {
+        build(*base, perPoint);
+        return;
+    }
+    pFirst = first / perPoint;
+    pLast = (last - 1) / perPoint; // included
+    if (pLast > nrPoints - 1)
+        pLast = nrPoints - 1;
+    for (int l = 1; l <= levels.size(); l++) {
+        step = 1 << l;
+        lo = (pFirst + step - 1) / step;
+        hi = pLast / step + 1;
+        for (j = lo; j < hi; j++)
+            copyPoint(j * step, l);
+        if (pLast == nrPoints - 1) {
+            copyPoint(nrPoints - 1, l);
+            hi = levelSize(l);
+        }
+        if (lo < hi)
+            levels[l - 1].update(lo * perPoint, hi * perPoint);
+    }
+    // the first point of a chunk is also the last one of the previous chunk
+    k = pFirst / LOD_CHUNK;
+    if (k > 0 && pFirst % LOD_CHUNK == 0)
+        k--;
+    for (; k < chunks.size() && k * LOD_CHUNK <= pLast; k++)
+        computeChunk(k);
+}
+
+// Draw the points first to last, included, of the level l.
+void LodStrip::drawPoints(int l, int first, int last)
+{
+    VertexBuffer &buf = l ? levels[l - 1] : *base;
+    buf.drawRange(first * perPoint, (last - first + 1) * perPoint);
+    drawnVertices += (last - first + 1) * perPoint;
+}
+
+// Draw the chunks whose box intersects the view, each from the coarsest level
+// where the points are still closer than the size of a pixel.
+void LodStrip::draw(float xMin, float yMin, float xMax, float yMax, float pixel)
+{
+    int runLevel = -1, runFirst = 0, runLast = 0, level, first, last;
+    drawnVertices = 0;
+    if (!base)
+        return;
+    for (int k = 0; k < chunks.size(); k++) {
+        Chunk &chunk = chunks[k];
+        if (chunk.xMax < xMin || chunk.xMin > xMax || chunk.yMax < yMin || chunk.yMin > yMax)
+            continue;
+        level = 0;
+        while (level < levels.size() && chunk.spacing * (2 << level) <= pixel)
+            level++;
+        first = (k * LOD_CHUNK) >> level;
+        if (k == chunks.size() - 1)
+            last = levelSize(level) - 1;
+        else
+            last = ((k + 1) * LOD_CHUNK) >> level;
+        // neighbor chunks on the same level are drawn together
+        if (level == runLevel && first == runLast)
+            runLast = last;
+        else {
+            if (runLevel >= 0)
+                drawPoints(runLevel, runFirst, runLast);
+            runLevel = level;
+            runFirst = first;
+            runLast = last;
+        }
+    }
+    if (runLevel >= 0)
+        drawPoints(runLevel, runFirst, runLast);
+}
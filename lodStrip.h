@@ -0,0 +1,73 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    lodStrip.h
+   Updated: October 2026
+
+   Definition of a class drawing a long strip of vertices with levels
+   of detail: the strip is split into chunks with a bounding box, the
+   chunks out of the view are skipped, and the others are drawn from a
+   decimated copy of the strip matching the size of a pixel.
+
+**********************************************************************/
+
+#ifndef LOD_STRIP_H
+#define LOD_STRIP_H
+
+#include "vertexBuffer.h"
+
+#define LOD_CHUNK 4096 // number of points in a chunk, a power of 2
+#define LOD_LEVELS 12  // at most log2(LOD_CHUNK) coarser levels
+
+class LodStrip {
+public:
+    int drawnVertices; // number of vertices drawn by the last call of draw
+
+    // Constructor: nothing to draw.
+    LodStrip();
+    // Copies are empty; they have to be built from their own buffer.
+    LodStrip(const LodStrip &other);
+    LodStrip &operator=(const LodStrip &other);
+
+    // Build the coarser levels and the chunks from the vertices of base, which
+    // is the finest level and must stay alive. The road points are made of
+    // perPoint vertices: 1 for a line, 2 for a ribbon.
+    void build(VertexBuffer &base, int perPoint);
+
+    // Remove the levels, so that draw doesn't do anything until the next build.
+    void clear();
+
+    // The vertices from first to last, not included, changed in the base buffer:
+    // update them in the coarser levels and the boxes of their chunks.
+    void update(int first, int last);
+
+    // Draw the chunks whose box intersects the view, each from the coarsest level
+    // where the points are still closer than the size of a pixel.
+    void draw(float xMin, float yMin, float xMax, float yMax, float pixel);
+
+private:
+    struct Chunk {
+        float xMin, yMin, xMax, yMax; // bounding box
+        float spacing;                // average distance between the points
+    };
+
+    VertexBuffer *base;
+    int perPoint, nrPoints;
+    vector<VertexBuffer> levels; // levels[l] keeps one point in 2^(l+1), and the last one
+    vector<Chunk> chunks;        // chunk k has the points k * LOD_CHUNK to (k + 1) * LOD_CHUNK
+
+    // Number of points in the level l, 0 being the base.
+    int levelSize(int l);
+
+    // Copy the point i of the base to the level l if it has one.
+    void copyPoint(int i, int l);
+
+    // Compute the box and spacing of the chunk k from the base.
+    void computeChunk(int k);
+
+    // Draw the points first to last, included, of the level l.
+    void drawPoints(int l, int first, int last);
+};
+
+#endif
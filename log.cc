@@ -0,0 +1,212 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    log.cc
+   Updated: October 2026
+
+   A logger with levels for the messages of the road pipeline. Each
+   thread formats its messages into its own ring buffer without any
+   lock, and a background thread writes them to the output.
+
+**********************************************************************/
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "log.h"
+
+#define LOG_RING_SIZE 1024 // messages in the buffer of each thread, a power of 2
+#define LOG_LINE 240       // longer messages are cut
+#define LOG_PERIOD 10      // milliseconds between two writes of the background thread
+
+// A message waiting to be written. The sequence number orders the messages of
+// different threads written together, but a message can get its number before
+// another thread's and only be published after that one was written.
+struct LogEntry {
+    unsigned long long seq;
+    char text[LOG_LINE];
+};
+
+// The messages of one thread. Only that thread moves the head and only the
+// reader moves the tail, so they don't need a lock. When the thread ends, the
+// buffer can be taken by a new one.
+struct LogRing {
+    LogEntry entries[LOG_RING_SIZE];
+    atomic<unsigned int> head, tail; // next entry to write, next entry to read
+    bool owned;
+};
+
+// Releases the buffer of the thread when it ends.
+struct LogRingOwner {
+    LogRing *ring;
+    ~LogRingOwner();
+};
+
+// The level given by ROADVIZ_LOG, or logInfo.
+static int levelFromEnv()
+{
+    const char *names[] = {"error", "warn", "info", "debug"};
+    const char *value = getenv("ROADVIZ_LOG");
+    if (value)
+        for (int i = logError; i <= logDebug; i++)
+            if (!strcmp(value, names[i]))
+                return i;
+    return logInfo;
+}
+
+atomic<int> logLevel(levelFromEnv());
+
+static atomic<unsigned long long> sequence(0);
+static atomic<long> dropped(0);
+static mutex ringsLock;          // adding or taking a buffer
+static vector<LogRing *> rings;  // never deleted, a new thread takes a free one
+static mutex readLock;           // only one reader of the buffers at a time
+static mutex wakeLock;
+static condition_variable wake;
+static bool stopping = false;
+static thread flusher;
+static once_flag started;
+
+LogRingOwner::~LogRingOwner()
+{
+    if (ring) {
+        unique_lock<mutex> guard(ringsLock);
+        ring->owned = false;
+    }
+}
+
+// The buffer of the current thread, taken on its first message.
+static LogRing &currentRing()
+{
+    thread_local LogRingOwner owner = {NULL};
+    if (!owner.ring) {
+        unique_lock<mutex> guard(ringsLock);
+        for (int i = 0; i < rings.size() && !owner.ring; i++)
+            if (!rings[i]->owned)
+                owner.ring = rings[i];
+        if (!owner.ring) {
+            owner.ring = new LogRing;
+            owner.ring->head = owner.ring->tail = 0;
+            rings.push_back(owner.ring);
+        }
+        owner.ring->owned = true;
+    }
+    return *owner.ring;
+}
+
+// Write the messages of all the buffers in the order of their sequence numbers.
+// The caller must hold readLock.
+static void drain()
+{
+    vector<LogRing *> all;
+    vector<unsigned int> heads;
+    vector<LogEntry *> batch;
+    {
+        unique_lock<mutex> guard(ringsLock);
+        all = rings;
+    }
+    for (int i = 0; i < all.size(); i++) {
+        unsigned int head = all[i]->head.load(memory_order_acquire);
+        for (unsigned int j = all[i]->tail.load(memory_order_relaxed); j != head; j++)
+            batch.push_back(&all[i]->entries[j & (LOG_RING_SIZE - 1)]);
+        heads.push_back(head);
+    }
+    if (batch.size()) {
+        sort(batch.begin(), batch.end(),
+             [](const LogEntry *a, const LogEntry *b) { return a->seq < b->seq; });
+        string out;
+        for (int i = 0; i < batch.size(); i++) {
+            out += batch[i]->text;
+            out += '\n';
+        }
+        cout << out << flush;
+    }
+    // the entries can be written again only once they are output
+    for (int i = 0; i < all.size(); i++)
+        all[i]->tail.store(heads[i], memory_order_release);
+    long lost = dropped.exchange(0);
+    if (lost)
+        cout << lost << " log messages were dropped" << endl;
+}
+
+// Main loop of the background thread.
+static void flushLoop()
+{
+    unique_lock<mutex> guard(wakeLock);
+    while (!stopping) {
+        wake.wait_for(guard, chrono::milliseconds(LOG_PERIOD));
+        guard.unlock();
+        {
+            unique_lock<mutex> reading(readLock);
+            drain();
+        }
+        guard.lock();
+    }
+}
+
+// Called when the program exits: stop the background thread and write what is left.
+static void logAtExit()
+{
+    {
+        unique_lock<mutex> guard(wakeLock);
+        stopping = true;
+    }
+    wake.notify_one();
+    flusher.join();
+    unique_lock<mutex> reading(readLock);
+    drain();
+}
+
+// Start the background thread.
+static void startFlusher()
+{
+    flusher = thread(flushLoop);
+    atexit(logAtExit);
+}
+
+// Set the level of the messages that are output.
+void setLogLevel(LogLevel level)
+{
+    logLevel = level;
+}
+
+// Add the message to the ring buffer of the current thread. If the buffer is
+// full, an info or debug message is dropped and counted rather than waiting,
+// while an error or a warning waits for the buffers to be written. The messages
+// of a thread keep their order; between threads, the order is best effort.
+void logWrite(LogLevel level, const string &message)
+{
+    call_once(started, startFlusher);
+    LogRing &ring = currentRing();
+    unsigned int head = ring.head.load(memory_order_relaxed);
+    unsigned int used = head - ring.tail.load(memory_order_acquire);
+    if (used >= LOG_RING_SIZE) {
+        if (level > logWarn) {
+            dropped++;
+            return;
+        }
+        logFlush(); // the errors and warnings are not lost
+    }
+    LogEntry &entry = ring.entries[head & (LOG_RING_SIZE - 1)];
+    entry.seq = sequence++;
+    strncpy(entry.text, message.c_str(), LOG_LINE - 1);
+    entry.text[LOG_LINE - 1] = 0;
+    ring.head.store(head + 1, memory_order_release);
+    if (level <= logWarn || used == LOG_RING_SIZE / 2)
+        wake.notify_one(); // the errors are written right away, and a half full buffer soon
+}
+
+// Write all the messages added so far before returning, for instance before
+// writing something else to the output.
+void logFlush()
+{
+    unique_lock<mutex> reading(readLock);
+    drain();
+}
@@ -0,0 +1,59 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    log.h
+   Updated: October 2026
+
+   A logger with levels for the messages of the road pipeline. Each
+   thread formats its messages into its own ring buffer without any
+   lock, and a background thread writes them to the output.
+
+**********************************************************************/
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <sstream>
+#include <string>
+#include <atomic>
+using namespace std;
+
+enum LogLevel {logError, logWarn, logInfo, logDebug};
+
+// The messages above this level are removed when compiling, for instance with
+// -DLOG_MAX_LEVEL=logInfo.
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL logDebug
+#endif
+
+// The messages above this level are ignored. It is logInfo by default, or
+// given by the environment variable ROADVIZ_LOG as error, warn, info or debug.
+extern atomic<int> logLevel;
+
+// Set the level of the messages that are output.
+void setLogLevel(LogLevel level);
+
+// Add the message to the ring buffer of the current thread. If the buffer is
+// full, an info or debug message is dropped and counted rather than waiting,
+// while an error or a warning waits for the buffers to be written. The messages
+// of a thread keep their order; between threads, the order is best effort.
+void logWrite(LogLevel level, const string &message);
+
+// Write all the messages added so far before returning, for instance before
+// writing something else to the output.
+void logFlush();
+
+// Log a message made with the << operator, as in LOG(logInfo, "min: " << min).
+// The message is not even formatted if its level is off.
+#define LOG(level, message)                                                  \
+    do {                                                                     \
+        if ((level) <= LOG_MAX_LEVEL &&                                      \
+            (level) <= logLevel.load(memory_order_relaxed)) {                \
+            ostringstream logStream;                                         \
+            logStream << message;                                            \
+            logWrite(level, logStream.str());                                \
+        }                                                                    \
+    } while (0)
+
+#endif
@@ -12,10 +12,26 @@
 #include <GL/glut.h>
 #include <cstdlib>
 #include "road.h"
+#include <cstring>
 #include "interface.h"
+#include "batch.h"
+#include "roadGen.h"
+#include "sweep.h"
+#include "trace.h"
 
+// "roadviz batch ..." runs without a window, see batch.h, and "roadviz gen ..."
+// writes a synthetic road, see roadGen.h, and "roadviz sweep ..." searches the
+// scales of a road file, see sweep.h. The environment variable ROADVIZ_TRACE
+// names a file to write a trace of the run in, see trace.h.
 int main(int argc, char **argv)
 {
+    traceFromEnv();
+    if (argc > 1 && !strcmp(argv[1], "batch"))
+        return batchMain(argc - 2, argv + 2);
+    if (argc > 1 && !strcmp(argv[1], "gen"))
+        return genMain(argc - 2, argv + 2);
+    if (argc > 1 && !strcmp(argv[1], "sweep"))
+        return sweepMain(argc - 2, argv + 2);
     glMainInit(argc, argv);
 }
 
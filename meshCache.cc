@@ -0,0 +1,266 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    meshCache.cc
+   Updated: October 2026
+
+   Spheres and tubes tessellated once for each precision, and batches
+   drawing many transformed copies of them in a single call.
+
+**********************************************************************/
+
+#define GL_GLEXT_PROTOTYPES
+#include <cmath>
+#include "meshCache.h"
+
+// Add the vertex with coordinates x, y, z and the normal nx, ny, nz to the mesh.
+static void addVertex(Mesh &mesh, GLfloat x, GLfloat y, GLfloat z,
+                      GLfloat nx, GLfloat ny, GLfloat nz)
+{
+    GLfloat vertex[MESH_STRIDE] = {x, y, z, nx, ny, nz};
+    mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + MESH_STRIDE);
+}
+
+// Add the triangles of a grid of vertices with rows of nrCols to the mesh. The
+// vertices of the quad (i, j) are ordered so that the triangles face outside.
+static void addGrid(Mesh &mesh, int nrRows, int nrCols, bool flip)
+{
+    for (int i = 0; i < nrRows - 1; i++)
+        for (int j = 0; j < nrCols - 1; j++) {
+            GLuint a = i * nrCols + j, b = a + nrCols, c = b + 1, d = a + 1;
+            if (flip)
+                swap(b, d);
+            GLuint quad[6] = {a, b, c, a, c, d};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+}
+
+// Tessellate a primitive with a number of slices around the z axis and of stacks
+// along it, like the GLU functions.
+static void tessellate(Mesh &mesh, MeshType type, int slices, int stacks)
+{
+    int i, j;
+    float theta, phi;
+    for (i = 0; i <= stacks; i++)
+        for (j = 0; j <= slices; j++) {
+            phi = 2 * M_PI * j / slices;
+            if (type == sphereMesh) {
+                theta = M_PI * i / stacks;
+                addVertex(mesh, sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta),
+                          sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+            }
+            else
+                addVertex(mesh, cos(phi), sin(phi), float(i) / stacks, cos(phi), sin(phi), 0);
+        }
+    // the sphere goes down from the north pole, the tube up from z = 0
+    addGrid(mesh, stacks + 1, slices + 1, type == tubeMesh);
+}
+
+// The mesh of a primitive with a precision from 1 to 3, as in the gl_draw
+// functions. It is tessellated at the first call and kept after that.
+// Only to be called from the thread drawing with OpenGL.
+const Mesh &getMesh(MeshType type, int precision)
+{
+    static Mesh meshes[nrMeshTypes][3];
+    int slices = 10, stacks;
+    if (precision < 1)
+        precision = 1;
+    if (precision > 3)
+        precision = 3;
+    Mesh &mesh = meshes[type][precision - 1];
+    if (mesh.vertices.empty()) {
+        if (precision == 3)
+            slices = 20;
+        if (type == sphereMesh)
+            stacks = slices;
+        else
+            stacks = precision == 3 ? 2 : 1;
+        mesh.wire = (precision == 1);
+        tessellate(mesh, type, slices, stacks);
+    }
+    return mesh;
+}
+
+// Draw the triangles from vertex and index arrays, or from the buffer objects bound
+// to them if the pointers are NULL.
+static void drawTriangles(const GLfloat *vertices, const GLuint *indices, int count,
+                          bool wire)
+{
+    if (wire) {
+        glPushAttrib(GL_POLYGON_BIT);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, MESH_STRIDE * sizeof(GLfloat), vertices);
+    glNormalPointer(GL_FLOAT, MESH_STRIDE * sizeof(GLfloat),
+                    (const GLvoid *)((const char *)vertices + 3 * sizeof(GLfloat)));
+    glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, indices);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (wire)
+        glPopAttrib();
+}
+
+// Draw a mesh with the current transformation.
+void drawMesh(const Mesh &mesh)
+{
+    drawTriangles(&mesh.vertices[0], &mesh.indices[0], mesh.indices.size(), mesh.wire);
+}
+
+// Constructor with the primitive and its precision.
+MeshBatch::MeshBatch(MeshType type, int precision)
+{
+    this->type = type;
+    this->precision = precision;
+    changed = false;
+    ids[0] = ids[1] = 0;
+    uploaded = 0;
+}
+
+// Copies only get the instances, the buffer objects belong to the original.
+MeshBatch::MeshBatch(const MeshBatch &other)
+{
+    type = other.type;
+    precision = other.precision;
+    instances = other.instances;
+    changed = true;
+    ids[0] = ids[1] = 0;
+    uploaded = 0;
+}
+
+// Copies only get the instances, the buffer objects belong to the original.
+MeshBatch &MeshBatch::operator=(const MeshBatch &other)
+{
+    if (this != &other) {
+        type = other.type;
+        precision = other.precision;
+        instances = other.instances;
+        changed = true;
+    }
+    return *this;
+}
+
+// Destructor: deletes the buffer objects if there are any.
+MeshBatch::~MeshBatch()
+{
+    if (ids[0])
+        glDeleteBuffers(2, ids);
+}
+
+// Remove all the instances.
+void MeshBatch::clear()
+{
+    instances.clear();
+    changed = true;
+}
+
+// Number of instances.
+int MeshBatch::size()
+{
+    return instances.size() / INSTANCE_SIZE;
+}
+
+// Add an ellipsoid with the given center and axes. Only for a sphere batch.
+void MeshBatch::addEllipsoid(GLfloat x, GLfloat y, GLfloat z,
+                             GLfloat axisX, GLfloat axisY, GLfloat axisZ)
+{
+    GLfloat instance[INSTANCE_SIZE] = {x, y, z, axisX, axisY, axisZ, 0, 0};
+    instances.insert(instances.end(), instance, instance + INSTANCE_SIZE);
+    changed = true;
+}
+
+// Add a tube from a to b with the radius ra at a and rb at b. Only for a
+// tube batch. Tubes shorter than 0.0001 are skipped.
+void MeshBatch::addTube(const Point3f &a, const Point3f &b, GLfloat ra, GLfloat rb)
+{
+    if (distance(a, b) <= 0.0001)
+        return;
+    GLfloat instance[INSTANCE_SIZE] = {a[0], a[1], a[2], b[0], b[1], b[2], ra, rb};
+    instances.insert(instances.end(), instance, instance + INSTANCE_SIZE);
+    changed = true;
+}
+
+// Transform the mesh for every instance and send the result to the buffer objects.
+void MeshBatch::upload()
+{
+    const Mesh &mesh = getMesh(type, precision);
+    int nrVertices = mesh.vertices.size() / MESH_STRIDE, nrInst = size(), i, k, v;
+    vector<GLfloat> vertices(nrInst * mesh.vertices.size());
+    vector<GLuint> indices(nrInst * mesh.indices.size());
+    GLfloat *out;
+    const GLfloat *in, *inst;
+    Point3f u, side, w, n;
+
+    for (k = 0; k < nrInst; k++) {
+        inst = &instances[k * INSTANCE_SIZE];
+        out = &vertices[k * mesh.vertices.size()];
+        in = &mesh.vertices[0];
+        if (type == sphereMesh)
+            for (v = 0; v < nrVertices; v++, in += MESH_STRIDE, out += MESH_STRIDE) {
+                n.set_data(in[3] / inst[3], in[4] / inst[4], in[5] / inst[5]);
+                n.normalize();
+                for (i = 0; i < 3; i++) {
+                    out[i] = inst[i] + in[i] * inst[3 + i];
+                    out[3 + i] = n[i];
+                }
+            }
+        else {
+            // w along the tube, u and side = w x u around it
+            float length, ra = inst[6], rb = inst[7], r;
+            w.set_data(inst[3] - inst[0], inst[4] - inst[1], inst[5] - inst[2]);
+            length = w.norm();
+            w *= 1 / length;
+            if (fabs(w[2]) < 0.9)
+                u.set_data(-w[1], w[0], 0);
+            else
+                u.set_data(0, -w[2], w[1]);
+            u.normalize();
+            side.set_data(w[1] * u[2] - w[2] * u[1], w[2] * u[0] - w[0] * u[2],
+                          w[0] * u[1] - w[1] * u[0]);
+            for (v = 0; v < nrVertices; v++, in += MESH_STRIDE, out += MESH_STRIDE) {
+                r = ra + (rb - ra) * in[2];
+                // the normal of a cone leans toward its narrow end
+                for (i = 0; i < 3; i++) {
+                    out[i] = inst[i] + r * (in[0] * u[i] + in[1] * side[i]) + in[2] * length * w[i];
+                    n[i] = length * (in[0] * u[i] + in[1] * side[i]) + (ra - rb) * w[i];
+                }
+                n.normalize();
+                for (i = 0; i < 3; i++)
+                    out[3 + i] = n[i];
+            }
+        }
+        for (i = 0; i < mesh.indices.size(); i++)
+            indices[k * mesh.indices.size() + i] = mesh.indices[i] + k * nrVertices;
+    }
+
+    if (!ids[0])
+        glGenBuffers(2, ids);
+    glBindBuffer(GL_ARRAY_BUFFER, ids[0]);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat),
+                 vertices.size() ? &vertices[0] : NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ids[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+                 indices.size() ? &indices[0] : NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    uploaded = indices.size();
+    drawn = instances;
+    changed = false;
+}
+
+// Draw all the instances.
+void MeshBatch::draw()
+{
+    if (changed && (!ids[0] || instances != drawn))
+        upload();
+    changed = false;
+    if (!uploaded)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, ids[0]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ids[1]);
+    drawTriangles(NULL, NULL, uploaded, getMesh(type, precision).wire);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
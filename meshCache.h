@@ -0,0 +1,88 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    meshCache.h
+   Updated: October 2026
+
+   Spheres and tubes tessellated once for each precision, and batches
+   drawing many transformed copies of them in a single call.
+
+**********************************************************************/
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <GL/glut.h>
+#include <vector>
+using namespace std;
+#include "point3f.h"
+
+#define MESH_STRIDE 6   // x, y, z, then the normal
+#define INSTANCE_SIZE 8 // floats describing an instance in a batch
+
+// The primitives of the cache. A cone is a tube with different radii at the ends.
+enum MeshType {sphereMesh, tubeMesh, nrMeshTypes};
+
+// A primitive tessellated as triangles: the sphere has radius 1 and the center
+// at the origin, the tube has radius 1 and goes along z from 0 to 1, open at
+// both ends like the GLU cylinders.
+struct Mesh {
+    vector<GLfloat> vertices; // MESH_STRIDE floats per vertex
+    vector<GLuint> indices;   // 3 per triangle
+    bool wire;                // drawn as lines, for the precision 1
+};
+
+// The mesh of a primitive with a precision from 1 to 3, as in the gl_draw
+// functions. It is tessellated at the first call and kept after that.
+// Only to be called from the thread drawing with OpenGL.
+const Mesh &getMesh(MeshType type, int precision);
+
+// Draw a mesh with the current transformation.
+void drawMesh(const Mesh &mesh);
+
+// Many copies of a mesh, each with its own transformation, drawn with a single
+// call. The transformed vertices are computed and sent to the buffer objects
+// only when the instances differ from those of the last upload, so a batch
+// cleared and given the same instances again is drawn as it is.
+class MeshBatch {
+public:
+    // Constructor with the primitive and its precision.
+    MeshBatch(MeshType type = sphereMesh, int precision = 2);
+    // Copies only get the instances, the buffer objects belong to the original.
+    MeshBatch(const MeshBatch &other);
+    MeshBatch &operator=(const MeshBatch &other);
+    // Destructor: deletes the buffer objects if there are any.
+    ~MeshBatch();
+
+    // Remove all the instances.
+    void clear();
+
+    // Number of instances.
+    int size();
+
+    // Add an ellipsoid with the given center and axes. Only for a sphere batch.
+    void addEllipsoid(GLfloat x, GLfloat y, GLfloat z,
+                      GLfloat axisX, GLfloat axisY, GLfloat axisZ);
+
+    // Add a tube from a to b with the radius ra at a and rb at b. Only for a
+    // tube batch. Tubes shorter than 0.0001 are skipped.
+    void addTube(const Point3f &a, const Point3f &b, GLfloat ra, GLfloat rb);
+
+    // Draw all the instances.
+    void draw();
+
+private:
+    MeshType type;
+    int precision;
+    vector<GLfloat> instances; // INSTANCE_SIZE floats each
+    bool changed;              // instances were added or removed since the last drawing
+    vector<GLfloat> drawn;     // the instances in the buffer objects
+    GLuint ids[2];             // vertex and index buffer objects, 0 if not created yet
+    int uploaded;              // number of indices in the buffer object
+
+    // Transform the mesh for every instance and send the result to the buffer objects.
+    void upload();
+};
+
+#endif
@@ -2,7 +2,7 @@
   File:         obj_container.cc
   Author:       Dana Vrajitoru
   Project:      Space Invaders
-  Last updated: September 10, 2007.
+  Last updated: October, 2026.
 
   Implementation of a class containing a collection of objects.
 
@@ -10,32 +10,41 @@
 
 #include "obj_container.h"
 
-// Constructor specifying 
+// Constructor specifying
 Obj_container::Obj_container(int dimx, int dimy, int howmany)
-  : Object()
+  : Object(), batch(GL_TRIANGLES)
 {
-  group = new Object[howmany];
-  for (int i=0; i<howmany; i++)
-    group[i].dimension.set_data(dimx, dimy);
+  if (howmany < 1)
+    howmany = 1;
+  obj_dim.set_data(dimx, dimy);
+  nr_alive = 0;
+  posx.resize(howmany);
+  posy.resize(howmany);
+  phase.resize(howmany, 1);
+  alive.resize(howmany);
+  generation.resize(howmany);
+  // the first places are taken first
+  for (int i=howmany-1; i>=0; i--)
+    free_list.push_back(i);
   count = howmany;
+  phase1_id = phase2_id = 0;
 
   // default color is white.
   color.set_data(1, 1, 1);
 }
 
-// Double the size of the group and copy all objects from the
-// previous one to the new one.
+// Double the size of the group. The objects keep their place and
+// the new places are free.
 void Obj_container::double_size()
 {
   int i;
-  Object *newgr = new Object[2*count];
-  // Copy all the objects into the new array.
-  for (i=0; i<count; i++)
-    newgr[i] = group[i];
-  // Copy the information from the last object in the old array into
-  // all the extra objects in the new arra.
-  for (i=count; i<2*count; i++)
-    newgr[i] = group[count-1];  
+  posx.resize(2*count, 0);
+  posy.resize(2*count, 0);
+  phase.resize(2*count, 1);
+  alive.resize(2*count, 0);
+  generation.resize(2*count, 0);
+  for (i=2*count-1; i>=count; i--)
+    free_list.push_back(i);
   count *= 2;
 }
 
@@ -53,6 +62,30 @@ void Obj_container::draw()
   phase2_id = glGenLists(1);
 }
 
+// Add the triangles of the shape for all the objects alive in the
+// phase ph to buf.
+void Obj_container::add_shapes(VertexBuffer &buf, vector<GLfloat> &shape, bool ph)
+{
+  for (int i=0; i<count; i++)
+    if (alive[i] && phase[i] == ph)
+      for (unsigned int j=0; j+1<shape.size(); j+=2)
+	buf.add(posx[i] + shape[j], posy[i] + shape[j+1],
+		color[0], color[1], color[2]);
+}
+
+// Store the triangles of the shapes of all the objects alive in buf,
+// first the ones in phase 1, then the ones in phase 2. Returns the
+// index of the first vertex of phase 2.
+int Obj_container::fill_shapes(VertexBuffer &buf)
+{
+  int first;
+  buf.clear();
+  add_shapes(buf, shape1, true);
+  first = buf.size();
+  add_shapes(buf, shape2, false);
+  return first;
+}
+
 // Call the display lists for all the objects that are alive. We
 // might not have to implement anything in the derived class.
 void Obj_container::display()
@@ -60,43 +93,113 @@ void Obj_container::display()
   glColor3f(color[0], color[1], color[2]);
   glPushMatrix();
   position.gl_translate();
-  for (int i=0; i<count; i++) 
-    if (group[i].alive) {
-      glPushMatrix();
-      // Translate by the position of the current object, then draw it.
-      group[i].position.gl_translate();
-      if (group[i].phase)
-	glCallList(phase1_id);
-      else
-	glCallList(phase2_id);
-      glPopMatrix();
-    }
+  if (shape1.size() || shape2.size()) {
+    // one call for each phase
+    int first = fill_shapes(batch);
+    batch.upload();
+    batch.drawRange(0, first);
+    batch.drawRange(first, batch.size() - first);
+  }
+  else {
+    // Translate by the difference to the previous object, then draw it.
+    float x = 0, y = 0;
+    for (int i=0; i<count; i++)
+      if (alive[i]) {
+	glTranslatef(posx[i] - x, posy[i] - y, 0);
+	x = posx[i];
+	y = posy[i];
+	if (phase[i])
+	  glCallList(phase1_id);
+	else
+	  glCallList(phase2_id);
+      }
+  }
   glPopMatrix();
 }
 
+// Give the place i to a new object at the position x, y.
+void Obj_container::bring_to_life(int i, float x, float y)
+{
+  alive[i] = 1;
+  phase[i] = 1;
+  posx[i] = x;
+  posy[i] = y;
+  nr_alive++;
+}
+
 // A function that will make one of the objects in the array come to
-// life at a given position on the screen. It finds the first object
-// in the array that is not alive, and brings it to life at the
-// given position. It returns the subscript of the activated object.
-int Obj_container::activate_any(int posx, int posy)
-{
-  for (int i=0; i<count; i++) 
-    if (!group[i].alive) {
-      group[i].resurect();
-      if (!group[i].move_to(posx, posy)) {
-	group[i].move_to(0, 0);
-	return i;
-      }
-    }
-  return -1;
+// life at a given position on the screen, or at 0, 0 if the
+// position is not on the table. It takes a free place in constant
+// time, doubling the size of the group if there is none. It returns
+// the subscript of the activated object.
+int Obj_container::activate_any(int x, int y)
+{
+  int i;
+  if (free_list.empty())
+    double_size();
+  i = free_list.back();
+  free_list.pop_back();
+  if (x >= 0 && y >= 0 && x + obj_dim.x < twidth && y + obj_dim.y < theight)
+    bring_to_life(i, x, y);
+  else
+    bring_to_life(i, 0, 0);
+  return i;
+}
+
+// Bring an object to life at any position and return its handle.
+Obj_handle Obj_container::activate(float x, float y)
+{
+  if (free_list.empty())
+    double_size();
+  int i = free_list.back();
+  free_list.pop_back();
+  bring_to_life(i, x, y);
+  return handle(i);
+}
+
+// Terminate the object i if it is alive, and free its place.
+void Obj_container::kill(int i)
+{
+  if (i < 0 || i >= count || !alive[i])
+    return;
+  alive[i] = 0;
+  generation[i]++;
+  free_list.push_back(i);
+  nr_alive--;
+}
+
+// Terminate the object of the handle if it is still alive. Returns
+// false if the handle was not valid anymore.
+bool Obj_container::kill(Obj_handle h)
+{
+  if (!is_valid(h))
+    return false;
+  kill(h.index);
+  return true;
+}
+
+// Is the object of the handle still the one it was given for?
+bool Obj_container::is_valid(Obj_handle h)
+{
+  return h.index >= 0 && h.index < count && alive[h.index] &&
+    generation[h.index] == h.generation;
+}
+
+// The handle of the object i, which must be alive.
+Obj_handle Obj_container::handle(int i)
+{
+  Obj_handle h;
+  h.index = i;
+  h.generation = generation[i];
+  return h;
 }
 
 // Main action for any of these objects defining how they move from
 // one frame to the next. To be defined by the derivate classes.
 void Obj_container::move()
 {
-  for (int i=0; i<count; i++) 
-    group[i].next_phase();
+  for (int i=0; i<count; i++)
+    phase[i] = !phase[i];
 }
 
 // Computes the bounding box of all the the objects in the container
@@ -2,7 +2,7 @@
   File:         obj_container.h
   Author:       Dana Vrajitoru
   Project:      Space Invaders
-  Last updated: March, 2019.
+  Last updated: October, 2026.
 
   Definition of a class containing a collection of objects.
 
@@ -11,16 +11,29 @@
 #ifndef OBJ_CONTAINER_H
 #define OBJ_CONTAINER_H
 
+#include <vector>
+using namespace std;
 #include "object.h"
 #include "point3f.h"
+#include "vertexBuffer.h"
+
+// Refers to one object of a container. It becomes invalid when the
+// object is killed, even if its place is given to a new object later.
+struct Obj_handle {
+  int index;
+  unsigned int generation;
+};
 
 class Obj_container : public Object{
  public:
-  // The group will have the size equal to count. We may have several
-  // copies of the same object with different positions and states,
-  // but using the same display lists.
-  Object *group;
-  int count;
+  // The objects are stored as one array for each of their
+  // attributes. We may have several copies of the same object with
+  // different positions and states, but using the same display lists.
+  vector<float> posx, posy;
+  vector<unsigned char> phase, alive;
+  int count;       // number of places for objects
+  int nr_alive;    // number of objects alive
+  Point2d obj_dim; // dimension of each object
   float vx, vy;
 
   Point3f color;
@@ -29,6 +42,12 @@ class Obj_container : public Object{
   // two phases of the object.
   GLuint phase1_id, phase2_id;
 
+  // Triangles of the two phases as x, y pairs relative to the
+  // position of an object. If the derived class fills them in draw,
+  // all the objects in the same phase are drawn with a single call
+  // instead of calling the display lists for each of them.
+  vector<GLfloat> shape1, shape2;
+
  public:
   // Constructor specifying the number of possible objects to be
   // created. By default it will create them all as unalive, but
@@ -36,8 +55,8 @@ class Obj_container : public Object{
   // constructor.
   Obj_container(int dimx=1, int dimy=1, int howmany = 1);
 
-  // Double the size of the group and copy all objects from the
-  // previous one to the new one.
+  // Double the size of the group. The objects keep their place and
+  // the new places are free.
   void double_size();
 
   // Sets the color of the objects.
@@ -51,11 +70,33 @@ class Obj_container : public Object{
   // might not have to implement anything in the derived class.
   virtual void display();
 
+  // Store the triangles of the shapes of all the objects alive in buf,
+  // first the ones in phase 1, then the ones in phase 2. Returns the
+  // index of the first vertex of phase 2.
+  int fill_shapes(VertexBuffer &buf);
+
   // A function that will make one of the objects in the array come to
-  // life at a given position on the screen. It finds the first object
-  // in the array that is not alive, and brings it to life at the
-  // given position. It returns the subscript of the activated object.
-  virtual int activate_any(int posx=0, int posy=0);
+  // life at a given position on the screen, or at 0, 0 if the
+  // position is not on the table. It takes a free place in constant
+  // time, doubling the size of the group if there is none. It returns
+  // the subscript of the activated object.
+  virtual int activate_any(int x=0, int y=0);
+
+  // Bring an object to life at any position and return its handle.
+  Obj_handle activate(float x, float y);
+
+  // Terminate the object i if it is alive, and free its place.
+  void kill(int i);
+
+  // Terminate the object of the handle if it is still alive. Returns
+  // false if the handle was not valid anymore.
+  bool kill(Obj_handle h);
+
+  // Is the object of the handle still the one it was given for?
+  bool is_valid(Obj_handle h);
+
+  // The handle of the object i, which must be alive.
+  Obj_handle handle(int i);
 
   // Main action for any of these objects defining how they move from
   // one frame to the next. To be defined by the derivate classes.
@@ -64,6 +105,18 @@ class Obj_container : public Object{
   // Computes the bounding box of all the the objects in the container
   // and stores it in the dimension of the container object.
   void compute_dimension();
+
+ private:
+  vector<unsigned int> generation; // changes each time a place is freed
+  vector<int> free_list;           // places not alive, the last one is used first
+  VertexBuffer batch;              // the shapes of the objects alive
+
+  // Give the place i to a new object at the position x, y.
+  void bring_to_life(int i, float x, float y);
+
+  // Add the triangles of the shape for all the objects alive in the
+  // phase ph to buf.
+  void add_shapes(VertexBuffer &buf, vector<GLfloat> &shape, bool ph);
 };
 
 #endif
@@ -0,0 +1,98 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    pngWriter.cc
+   Updated: October 2026
+
+   A function writing an RGBA picture in a PNG file, using zlib for
+   the compression.
+
+**********************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <zlib.h>
+#include "pngWriter.h"
+#include "log.h"
+
+// Append a 4 byte integer to the data, most significant byte first.
+static void addInt(vector<unsigned char> &data, unsigned int value)
+{
+    data.push_back(value >> 24);
+    data.push_back((value >> 16) & 255);
+    data.push_back((value >> 8) & 255);
+    data.push_back(value & 255);
+}
+
+// Write a chunk of the file: the length, the type, the data, and the CRC
+// of the type and data.
+static void writeChunk(ofstream &fout, const char *type,
+                       const unsigned char *data, unsigned int length)
+{
+    vector<unsigned char> head;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    addInt(head, length);
+    head.insert(head.end(), type, type + 4);
+    crc = crc32(crc, (const Bytef *)type, 4);
+    if (length)
+        crc = crc32(crc, data, length);
+    fout.write((const char *)&head[0], head.size());
+    if (length)
+        fout.write((const char *)data, length);
+    head.clear();
+    addInt(head, crc);
+    fout.write((const char *)&head[0], head.size());
+}
+
+// Write a picture of width x height pixels in a PNG file. The pixels are
+// stored as red, green, blue, alpha, row by row from the top. Returns false
+// if the file could not be written.
+bool writePNG(const char *filename, int width, int height,
+              const vector<unsigned char> &pixels)
+{
+    static const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    vector<unsigned char> header, raw, packed;
+    int rowSize = 4 * width;
+    uLongf packedSize;
+
+    if (width <= 0 || height <= 0 || pixels.size() < size_t(rowSize) * height) {
+        LOG(logError, "Cannot write an empty picture to " << filename);
+        return false;
+    }
+    // 8 bits per channel, RGBA, no interlacing
+    addInt(header, width);
+    addInt(header, height);
+    header.push_back(8);
+    header.push_back(6);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    // each row starts with the filter type, 0 for none
+    raw.resize(size_t(rowSize + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw[size_t(rowSize + 1) * y] = 0;
+        copy(pixels.begin() + size_t(rowSize) * y, pixels.begin() + size_t(rowSize) * (y + 1),
+             raw.begin() + size_t(rowSize + 1) * y + 1);
+    }
+    packedSize = compressBound(raw.size());
+    packed.resize(packedSize);
+    if (compress2(&packed[0], &packedSize, &raw[0], raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+        LOG(logError, "Could not compress the picture for " << filename);
+        return false;
+    }
+
+    ofstream fout(filename, ios::binary);
+    if (!fout.good()) {
+        LOG(logError, "Could not open the picture file " << filename);
+        return false;
+    }
+    fout.write((const char *)signature, 8);
+    writeChunk(fout, "IHDR", &header[0], header.size());
+    writeChunk(fout, "IDAT", &packed[0], packedSize);
+    writeChunk(fout, "IEND", NULL, 0);
+    fout.close();
+    return fout.good();
+}
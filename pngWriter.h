@@ -0,0 +1,25 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    pngWriter.h
+   Updated: October 2026
+
+   A function writing an RGBA picture in a PNG file, using zlib for
+   the compression.
+
+**********************************************************************/
+
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <vector>
+using namespace std;
+
+// Write a picture of width x height pixels in a PNG file. The pixels are
+// stored as red, green, blue, alpha, row by row from the top. Returns false
+// if the file could not be written.
+bool writePNG(const char *filename, int width, int height,
+              const vector<unsigned char> &pixels);
+
+#endif
@@ -13,9 +13,30 @@
 #include <cmath>
 #include <cstring>
 #include <algorithm>
+#include <sstream>
+#include <atomic>
+#include <cfloat>
 #include "road.h"
+#include "bandMatrix.h"
+#include "fitnessCache.h"
+#include "trajColor.h"
+#include "trace.h"
+#include "log.h"
+#include "threadPool.h"
 #include "General.h"
 
+#define POINT_GRAIN 4096 // number of points handled by one task of the loops on the road
+#define MULTI_INC 0.05   // step of multiLevelTraj at the finest level while inc is 0
+
+static atomic<unsigned int> lastVersion(0);
+
+// A version that no road had before, so that the versions of different roads
+// can't be mistaken for each other, for instance by a shared fitness cache.
+static unsigned int newVersion()
+{
+    return ++lastVersion;
+}
+
 // Optimal road scales + left scale:
 // E-Track4 0.85  left
 // E-Track4 0.06  right *
@@ -23,6 +44,7 @@
 // E-Road   0.036 left
 // Alpine2  0.067 left
 // Alpine2  0.15  0.62 right *
+// "roadviz sweep" searches these values, see sweep.h.
 
 /////////// Skip step values
 // E-Track5 2.5 right
@@ -61,7 +83,6 @@ void Road::init()
     flatLength = 10;
     maxCurv = 1;
     roadId = 0;
-    trajId = 0;
     almostFlat = 0.1;
     curvScale = 2;
     curveLength = 1;
@@ -71,8 +92,15 @@ void Road::init()
     // up to here the values don't have to make sense
     hasTraj = true;
     rdType = allScale; // skipStep;
+    colorMode = keyFrameColor;
+    showMarkers = false;
+    markersDirty = true;
     roadStep = 3.8;
     trajStep = 5;
+    version = newVersion();
+    totalDist = totalCurv = 0;
+    scoreStart = scoreEnd = 0;
+    scoreVersion = 0;
 }
 
 // initialize the road from a file 
@@ -105,6 +133,7 @@ void Road::init(char *filename, float startPt, float endPt)
 // Initialize settings from a dictionary 
 void Road::init(char **aDict, int nOpt)
 {
+    version = newVersion();
     for (int i = 0; i < nOpt; i++)
         if (strcmp(aDict[2 * i], "almost flat") == 0)
             almostFlat = atof(aDict[2 * i + 1]);
@@ -122,6 +151,28 @@ void Road::init(char **aDict, int nOpt)
             curveLength = atoi(aDict[2 * i + 1]);
 }
 
+// Copy the settings of another road, but not its points.
+void Road::copySettings(const Road &other)
+{
+    version = newVersion(); // the evaluation depends on the width
+    min = other.min;
+    max = other.max;
+    maxCurv = other.maxCurv;
+    almostFlat = other.almostFlat;
+    inc = other.inc;
+    curvScale = other.curvScale;
+    leftScale = other.leftScale;
+    roadScale = other.roadScale;
+    roadWidth = other.roadWidth;
+    roadStep = other.roadStep;
+    trajStep = other.trajStep;
+    flatLength = other.flatLength;
+    curveLength = other.curveLength;
+    hasWidth = other.hasWidth;
+    hasTraj = other.hasTraj;
+    rdType = other.rdType;
+}
+
 // set the values of a particular point
 void Road::setPt(int i, float d, Point3f &p, float c)
 {
@@ -134,11 +185,12 @@ void Road::setPt(int i, float d, Point3f &p, float c)
 // Read the road from a file and store the points in the vector
 void Road::read(char *filename)
 {
+    TRACE_SCOPE("Road::read");
     ifstream fin(filename);
     if (fin.good())
         readPointList(fin);
     else
-        cout << "Could not open the road file " << filename << endl;
+        LOG(logError, "Could not open the road file " << filename);
     fin.close();
 }
 
@@ -146,11 +198,12 @@ void Road::read(char *filename)
 // and store the points in the vector
 void Road::readCenter(char* filename)
 {
+    TRACE_SCOPE("Road::readCenter");
     ifstream fin(filename);
     if (fin.good())
         readCenterList(fin);
     else
-        cout << "Could not open the road centerline file " << filename << endl;
+        LOG(logError, "Could not open the road centerline file " << filename);
     fin.close();
 }
 
@@ -158,27 +211,67 @@ void Road::readCenter(char* filename)
 // and store the points in the vector
 void Road::readCenter(char* filename, InterpType inter, float step)
 {
+    TRACE_SCOPE("Road::readCenter");
     ifstream fin(filename);
     if (fin.good())
         readCenterList(fin, inter, step);
     else
-        cout << "Could not open the road centerline file " << filename << endl;
+        LOG(logError, "Could not open the road centerline file " << filename);
     fin.close();
 }
 
-// Call the display list.
-void Road::display()
+// Draw the vertex buffers, or call the display list if the road was drawn from a file.
+// Only the parts inside the view from viewMin to viewMax are drawn, with the level
+// of detail matching the size of a pixel.
+void Road::display(Point3f &viewMin, Point3f &viewMax, float pixel)
 {
+    TRACE_SCOPE("Road::display");
     //glColor3f(color[0], color[1], color[2]);
     glPushMatrix();
     //position.gl_translate();
-    glCallList(roadId);
-
-    if (hasTraj)
-        glCallList(trajId);
+    if (roadBuf.size())
+        roadLod.draw(viewMin.x(), viewMin.y(), viewMax.x(), viewMax.y(), pixel);
+    else
+        glCallList(roadId);
+
+    if (hasTraj) {
+        glLineWidth(1.5);
+        trajLod.draw(viewMin.x(), viewMin.y(), viewMax.x(), viewMax.y(), pixel);
+        if (showMarkers) {
+            if (markersDirty)
+                drawMarkers();
+            glColor3f(0, 1, 0);
+            keyMarkers.draw();
+            glColor3f(1, 1, 0);
+            ctrlMarkers.draw();
+        }
+    }
     glPopMatrix();
 }
 
+// Place a sphere on the trajectory at every keyframe and control point,
+// with a radius of half the width of the road, so that they don't change
+// with the zoom.
+void Road::drawMarkers()
+{
+    // flat enough to stay inside the depth range of the view
+    float radius = roadWidth / 2, depth = radius < 0.5 ? radius : 0.5;
+    int n = points.size();
+    keyMarkers.clear();
+    ctrlMarkers.clear();
+    for (unsigned int i = 0; i < keyframes.size(); i++)
+        if (keyframes[i].pt >= 0 && keyframes[i].pt < n) {
+            Point3f &p = points[keyframes[i].pt].trjPt;
+            keyMarkers.addEllipsoid(p.x(), p.y(), 0, radius, radius, depth);
+        }
+    for (unsigned int i = 0; i < ctrlPts.size(); i++)
+        if (ctrlPts[i] >= 0 && ctrlPts[i] < n) {
+            Point3f &p = points[ctrlPts[i]].trjPt;
+            ctrlMarkers.addEllipsoid(p.x(), p.y(), 0, radius, radius, depth);
+        }
+    markersDirty = false;
+}
+
 // To be reimplemented for this class.
 void Road::draw(char *filename)
 {
@@ -191,7 +284,7 @@ void Road::draw(char *filename)
         else
             drawRibbonPtList(fin);
     else
-        cout << "Could not open the road file " << filename << endl;
+        LOG(logError, "Could not open the road file " << filename);
     fin.close();
 }
 
@@ -204,17 +297,13 @@ void Road::draw(char *filename, float startPt, float endPt)
     if (fin.good())
         readPointList(fin, startPt, endPt);
     else
-        cout << "Could not open the road file " << filename << endl;
+        LOG(logError, "Could not open the road file " << filename);
     fin.close();
 }
 
 // Draw from the list of points already stored.
 void Road::draw()
 {
-    // get id numbers for the display lists
-    roadId = glGenLists(1);
-    trajId = glGenLists(1);
-
     if (!hasWidth)
         drawLineFromPoints();
     else
@@ -224,120 +313,132 @@ void Road::draw()
         drawTrajFromPoints();
 }
 
-// Create the display list from a list of points already stored. 
+// Fill the road vertex buffer from a list of points already stored. 
 // Display the road as a line
 void Road::drawLineFromPoints()
 {
-    glNewList(roadId, GL_COMPILE);
-    glColor3f(1, 1, 0);  // yellow
-    glBegin(GL_LINE_STRIP);
-    for (unsigned int i = 0; i < points.size(); i++)
-        glVertex2f(points[i].pt.x(), points[i].pt.y());
-    glEnd();
-    glEndList();
+    TRACE_SCOPE("Road::drawLineFromPoints");
+    fillLineVertices(roadBuf);
+    roadBuf.upload();
+    roadLod.build(roadBuf, 1);
     //cout << "min: " << min << " max: " << max << endl;
 }
 
-// Create the display list from a list of points already stored. 
+// Fill the road vertex buffer from a list of points already stored. 
 // Display the road as a ribbon
 void Road::drawRibbonFromPoints()
 {
-    Point3f pt(0, 0, 0), dir(1, 0, 0), nor(0, 0, 0),
-            pt1(points[0].pt.x(), points[0].pt.y() + 2*roadWidth, 0), 
-            pt2(points[0].pt.x(), points[0].pt.y() - roadWidth, 0);
-    int nrpt = points.size();
-    glNewList(roadId, GL_COMPILE);
-    glColor3f(1, 1, 0);  // yellow
-    glBegin(GL_TRIANGLE_STRIP);
-    glVertex2f(pt1.x(), pt1.y());
-    glVertex2f(pt2.x(), pt2.y());
-    for (unsigned int i = 1; i < nrpt; i++) 
-    {
-        pt = points[i].pt;
-        dir = pt;
-        dir -= points[i - 1].pt;
-        nor = points[i].norm; // already computed
-        if (nrpt > 2000 && i < 100)
-            nor *= 2 * roadWidth;
-        else
-            nor *= roadWidth;
-        pt1 = pt;
-        pt1 += nor;
-        pt2 = pt;
-        pt2 -= nor;
-        glVertex2f(pt1.x(), pt1.y());
-        glVertex2f(pt2.x(), pt2.y());
-    }
-    glEnd();
-    glEndList();
+    TRACE_SCOPE("Road::drawRibbonFromPoints");
+    fillRibbonVertices(roadBuf);
     if (points.size() > 1)
         points[0].norm = points[1].norm;
+    roadBuf.upload();
+    roadLod.build(roadBuf, 2);
     //cout << "min: " << min << " max: " << max << endl;
 }
 
-// set the color of the trajectory based on various options
-void Road::setTrajColor(int i, GLfloat &red, GLfloat &blue)
+// Store the vertices of the centerline in buf as a line strip.
+void Road::fillLineVertices(VertexBuffer &buf) const
 {
-    int select = 3;
-    static int kf = 0;
-    switch(select)
-    {
-    case 0:
-        blue = red = 0;
-        // red for real curvature and road  curvature going in the same direction
-        if (points[i].curv * realTrajCurv(i) >= 0)
-            red = 1;
-        else
-            blue = 1;
-        break;
-    case 1:
-        blue = red = 0;
-        blue = 0.5 * (points[i].curv + 1) / maxCurv;
-        red = 0.5 * (realTrajCurv(i) + 1) / maxCurv;
-        break;
-    case 2:
-        blue = red = 0;
-        // if i is in the control points
-        if (find(ctrlPts.begin(), ctrlPts.end(), i) != ctrlPts.end())
-            blue = 1;
-        else
-            red = 1;
-        break;
-    case 3:
-        if (i == 1)
-            kf = 1;
-        // every time we hit a control point, switch
-        if (kf < keyframes.size() && keyframes[kf].pt == i)
+    buf.clear();
+    buf.mode = GL_LINE_STRIP;
+    buf.data.resize(points.size() * VB_STRIDE);
+    parallel_for(0, points.size(), POINT_GRAIN, [this, &buf](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            buf.set(i, points[i].pt[0], points[i].pt[1], 1, 1, 0); // yellow
+    });
+}
+
+// Store the vertices of the road in buf as a triangle strip.
+void Road::fillRibbonVertices(VertexBuffer &buf) const
+{
+    Point3f pt1(points[0].pt[0], points[0].pt[1] + 2*roadWidth, 0), 
+            pt2(points[0].pt[0], points[0].pt[1] - roadWidth, 0);
+    int nrpt = points.size();
+    buf.clear();
+    buf.mode = GL_TRIANGLE_STRIP;
+    buf.data.resize(2 * nrpt * VB_STRIDE);
+    buf.set(0, pt1.x(), pt1.y(), 1, 1, 0); // yellow
+    buf.set(1, pt2.x(), pt2.y(), 1, 1, 0);
+    // each point gives two vertices that depend only on that point
+    parallel_for(1, nrpt, POINT_GRAIN, [this, &buf, nrpt](int begin, int end) {
+        Point3f pt, nor, pt1, pt2;
+        for (int i = begin; i < end; i++) 
         {
-            kf++;
-            red = 1 - red;
-            blue = 1 - blue;
+            pt = points[i].pt;
+            nor = points[i].norm; // already computed
+            if (nrpt > 2000 && i < 100)
+                nor *= 2 * roadWidth;
+            else
+                nor *= roadWidth;
+            pt1 = pt;
+            pt1 += nor;
+            pt2 = pt;
+            pt2 -= nor;
+            buf.set(2 * i, pt1.x(), pt1.y(), 1, 1, 0);
+            buf.set(2 * i + 1, pt2.x(), pt2.y(), 1, 1, 0);
         }
-        break;
+    });
+}
+
+// Change the coloring of the trajectory and draw it again.
+void Road::setColorMode(TrajColorMode mode)
+{
+    colorMode = mode;
+    trajDirty.mark(0, points.size());
+    drawTrajFromPoints();
+}
+
+// Store the vertices of the whole trajectory in buf as a line strip.
+void Road::fillTrajVertices(VertexBuffer &buf) const
+{
+    int n = points.size();
+    buf.clear();
+    buf.mode = GL_LINE_STRIP;
+    buf.data.resize(n * VB_STRIDE);
+    if (n)
+        buf.set(0, points[0].pt[0], points[0].pt[1], 0.5, 0, 0.5);  // purple
+    setTrajVertices(buf, 1, n);
+}
+
+// Set the vertices of the trajectory points from first to last, not included, 
+// in buf, which must already have a vertex for every point. The colors of all 
+// the points are computed at once by the color stage.
+void Road::setTrajVertices(VertexBuffer &buf, int first, int last) const
+{
+    if (first >= last)
+        return;
+    for (int i = first; i < last; i++)
+    {
+        buf.data[i * VB_STRIDE] = points[i].trjPt[0];
+        buf.data[i * VB_STRIDE + 1] = points[i].trjPt[1];
     }
+    computeTrajColors(*this, colorMode, first, last, &buf.data[first * VB_STRIDE + 2],
+                      VB_STRIDE, sharedPool());
 }
 
-// Create the display list from the stored trajectory 
+// Fill the trajectory vertex buffer from the stored trajectory. If only some 
+// points changed since the last call, only their vertices are sent again.
 void Road::drawTrajFromPoints()
 {
-    Point3f pt(0, 0, 0), dir(1, 0, 0), nor(0, 0, 0), pt1(0, 0, 0);
-    GLfloat blueCmp = 0, redCmp = 1;
-    glDeleteLists(trajId, 1);
-    glNewList(trajId, GL_COMPILE);
-    glColor3f(0.5, 0, 0.5);  // purple
-    glLineWidth(1.5);
-    glBegin(GL_LINE_STRIP);
-    glVertex2f(points[0].pt.x(), points[0].pt.y());
-    for (unsigned int i = 1; i < points.size(); i++)
+    TRACE_SCOPE("Road::drawTrajFromPoints");
+    int n = points.size(), first, last;
+    if (trajBuf.size() == n && !trajDirty.empty())
     {
-        pt1 = points[i].trjPt;
-        // now set the color
-        setTrajColor(i, redCmp, blueCmp);
-        glColor3f(redCmp, 0, blueCmp);
-        glVertex2f(pt1.x(), pt1.y());
+        first = MMAX(trajDirty.start, 1);
+        last = MMIN(trajDirty.end, n);
+        setTrajVertices(trajBuf, first, last);
+        trajBuf.update(first, last);
+        trajLod.update(first, last);
     }
-    glEnd();
-    glEndList();
+    else
+    {
+        fillTrajVertices(trajBuf);
+        trajBuf.upload();
+        trajLod.build(trajBuf, 1);
+    }
+    trajDirty.clear();
+    markersDirty = true; // the markers follow the trajectory
 }
 
 // Read the data from the file, calculate and draw the points 
@@ -382,7 +483,7 @@ void Road::drawPointList(ifstream &fin)
     }
     glEnd();
     glEndList();
-    cout << "min: " << min << " max: " << max << endl;
+    LOG(logInfo, "min: " << min << " max: " << max);
 }
 
 // Draw the points list as a ribbon if the road has a width
@@ -439,22 +540,24 @@ void Road::drawRibbonPtList(ifstream &fin)
     }
     glEnd();
     glEndList();
-    cout << "min: " << min << " max: " << max << endl;
+    LOG(logInfo, "min: " << min << " max: " << max);
 }
 
 // Read the data from the file, calculate and store the points 
 void Road::readPointList(ifstream &fin)
 {
     if (rdType == allScale)
-        readPointList(fin, 0, 1000000);
+        readPointList(fin, 0, FLT_MAX);
     else
-        readStepPointList(fin, 0, 1000000);
+        readStepPointList(fin, 0, FLT_MAX);
 
 }
 
 // Read the centerline points from the file, calculate and store the curvature 
 void Road::readCenterList(ifstream &fin)
 {
+    TRACE_SCOPE("Road::readCenterList");
+    version = newVersion();
     int nrPoints;
     float cosTau, sinTau, totalDist, realDist, scaleF;
     fin >> nrPoints >> realDist;
@@ -493,20 +596,24 @@ void Road::readCenterList(ifstream &fin)
         }
     }
     totalDist = points[nrPoints - 1].dist + points[nrPoints - 1].pt.distance(points[0].pt);
-    cout << "min: " << min << " max: " << max << " maxCurv " << maxCurv 
-        << " total dist " << totalDist << endl;
+    TRACE_COUNT("road points", points.size());
+    LOG(logInfo, "min: " << min << " max: " << max << " maxCurv " << maxCurv 
+        << " total dist " << totalDist);
 }
 
 // Read the centerline points from the file, interpolate the points following 
 // a given step and an interpolation type, then calculate and store the curvature 
 void Road::readCenterList(ifstream& fin, InterpType inter, float step)
 {
+    TRACE_SCOPE("Road::readCenterList resample");
+    version = newVersion();
     if (inter != linear && inter != cubic)
         return readCenterList(fin);
     int nrPoints, j = 1;
     float cosTau, sinTau, totalDist, realDist, scaleF, alpha = 0, inc;
     fin >> nrPoints >> realDist;
     RoadPt point, point1, point2;
+    QuadCurve curve; // the polynomials between point1 and point2
     Point3f nor(0, 1, 0), pt1, pt2;
     point1.norm = nor;
     fin >> point1.pt[0] >> point1.pt[1];
@@ -544,12 +651,12 @@ void Road::readCenterList(ifstream& fin, InterpType inter, float step)
         inc = step / (point2.dist - point1.dist);
         alpha = (point.dist - point1.dist) / (point2.dist - point1.dist);
         if (inter == quadr)
-            point.quadraticInterpolate(point1, point2, 0); // recalculate the polynomial
+            point.quadraticInterpolate(point1, point2, 0, curve); // recalculate the polynomial
         while (point.dist < point2.dist || alpha < 1) {
             if (inter == linear)
                 point.linearInterpolate(point1, point2, alpha);
             else if (inter == quadr) {
-                point.quadraticInterpolate(point1, point2, alpha);
+                point.quadraticInterpolate(point1, point2, alpha, curve);
                 point.dist = points[points.size() - 1].dist +
                     point.pt.distance(points[points.size() - 1].pt);
             }
@@ -559,28 +666,75 @@ void Road::readCenterList(ifstream& fin, InterpType inter, float step)
         copyPoint(point1, point2);
     }
     totalDist = points[nrPoints - 1].dist + points[nrPoints - 1].pt.distance(points[0].pt);
-    cout << "min: " << min << " max: " << max << " maxCurv " << maxCurv
-        << " total dist " << totalDist << endl;
+    TRACE_COUNT("road points", points.size());
+    LOG(logInfo, "min: " << min << " max: " << max << " maxCurv " << maxCurv
+        << " total dist " << totalDist);
+}
+
+// Read all the pairs of distance and curvature from the file.
+void readCurvData(ifstream &fin, CurvData &data)
+{
+    TRACE_SCOPE("readCurvData");
+    double dist;
+    float curv;
+    data.dist.clear();
+    data.curv.clear();
+    while (fin >> dist) {
+        curv = 0; // the curvature of the last point is never used
+        fin >> curv;
+        data.dist.push_back(dist);
+        data.curv.push_back(curv);
+    }
 }
 
 // Read the data from the file, calculate and store the points 
 void Road::readPointList(ifstream &fin, float startPt, float endPt)
 {
+    TRACE_SCOPE("Road::readPointList");
+    CurvData data;
+    readCurvData(fin, data);
+    buildPointList(data, startPt, endPt);
+    TRACE_COUNT("road points", points.size());
+    LOG(logInfo, "min: " << min << " max: " << max << " maxCurv " << maxCurv);
+}
+
+// Read the data from the file using a step, storing only 1 in a number, 
+// then calculate and store the points 
+void Road::readStepPointList(ifstream &fin, float startPt, float endPt)
+{
+    TRACE_SCOPE("Road::readStepPointList");
+    CurvData data;
+    readCurvData(fin, data);
+    buildStepPointList(data, startPt, endPt);
+    TRACE_COUNT("road points", points.size());
+    LOG(logInfo, "min: " << min << " max: " << max << " maxCurv " << maxCurv);
+}
+
+// Calculate and store the points from the data between startPt and endPt,
+// with the scales of the road.
+void Road::buildPointList(const CurvData &data, float startPt, float endPt)
+{
+    version = newVersion();
     if (points.size()) // delete old data
         points.clear();
     Point3f pt(0, 0, 0), dir(1, 0, 0), nor(0, 1, 0);
     RoadPt point;
-    int i = 0;
-    float dist, cosTau, sinTau, oldDist = 0, deltad, dx, dy;
-    fin >> oldDist >> sinTau >> dist;
+    int i = 0, n = data.dist.size();
+    double dist, oldDist, deltad;
+    float cosTau, sinTau, dx, dy;
+    if (n == 0)
+        return;
+    oldDist = data.dist[0];
+    sinTau = data.curv[0];
     if (oldDist >= startPt && oldDist <= endPt) {
         points.push_back(point);
         points[0].norm = nor;
         setPt(i++, oldDist, pt, sinTau);
     }
     updateMinMax(pt, sinTau);
-    while (fin.good() & !fin.eof()) {
+    for (int k = 1; k < n; k++) {
         // calculate new pt and dir
+        dist = data.dist[k];
 
         if (dist >= startPt && dist <= endPt) {
             deltad = dist - oldDist;
@@ -594,8 +748,6 @@ void Road::readPointList(ifstream &fin, float startPt, float endPt)
             dy = -dir.x() * sinTau + dir.y() * cosTau;
             dir.x() = dx;
             dir.y() = dy;
-            //if (sinTau > 0)
-            //cout << dist << '\t' << cosTau << ' ' << sinTau << '\t' << dir << endl;
             // set the length od dir to deltad
             dir.normalize();
             nor.x() = -dir.y();   // perpendicular in the xy plane
@@ -615,22 +767,26 @@ void Road::readPointList(ifstream &fin, float startPt, float endPt)
 
         // update the data
         oldDist = dist;
-        fin >> sinTau >> dist;
+        sinTau = data.curv[k];
     }
-    cout << "min: " << min << " max: " << max << " maxCurv " << maxCurv << endl;
 }
 
-// Read the data from the file using a step, storing only 1 in a number, 
-// then calculate and store the points 
-void Road::readStepPointList(ifstream &fin, float startPt, float endPt)
+// Calculate and store the points from the data using a step, storing only 1
+// in a number.
+void Road::buildStepPointList(const CurvData &data, float startPt, float endPt)
 {
+    version = newVersion();
     if (points.size()) // delete old data
         points.clear();
     Point3f pt(0, 0, 0), dir(1, 0, 0), nor(0, 1, 0);
     RoadPt point;
-    int i = 0, j = 0, aveCount=0;
-    float dist, cosTau, sinTau, sumSinTau=0, oldDist = 0, deltad=0, dx, dy, stepSum = 0;
-    fin >> oldDist >> sinTau >> dist;
+    int i = 0, j = 0, aveCount=0, n = data.dist.size();
+    double dist, oldDist, deltad = 0;
+    float cosTau, sinTau, sumSinTau=0, dx, dy, stepSum = 0;
+    if (n == 0)
+        return;
+    oldDist = data.dist[0];
+    sinTau = data.curv[0];
     if (oldDist >= startPt && oldDist <= endPt) {
         points.push_back(point);
         points[0].norm = nor;
@@ -640,8 +796,9 @@ void Road::readStepPointList(ifstream &fin, float startPt, float endPt)
         aveCount++;
     }
     updateMinMax(pt, sinTau);
-    while (fin.good() & !fin.eof()) {
+    for (int k = 1; k < n; k++) {
         // calculate new pt and dir
+        dist = data.dist[k];
 
         if (dist >= startPt && dist <= endPt) {
             deltad += dist - oldDist;
@@ -656,8 +813,6 @@ void Road::readStepPointList(ifstream &fin, float startPt, float endPt)
                 dy = -dir.x() * sinTau + dir.y() * cosTau;
                 dir.x() = dx;
                 dir.y() = dy;
-                //if (sinTau > 0)
-                //cout << dist << '\t' << cosTau << ' ' << sinTau << '\t' << dir << endl;
                 // set the length od dir to deltad
                 dir.normalize();
                 nor.x() = -dir.y();   // perpendicular in the xy plane
@@ -682,17 +837,25 @@ void Road::readStepPointList(ifstream &fin, float startPt, float endPt)
 
         // update the data
         oldDist = dist;
-        fin >> sinTau >> dist;
+        sinTau = data.curv[k];
         i++;
         stepSum += 1;
         aveCount++;
     }
-    cout << "min: " << min << " max: " << max << " maxCurv " << maxCurv << endl;
 }
 
 // Compute the real value of the trajectory point given the normal to the centerline
 // and the trajectory value
 void Road::computeTrajPt(int i)
+{
+    placeTrajPt(i);
+    // the colors depending on the curvature also change on both sides
+    trajDirty.mark(i - 1, i + 2);
+}
+
+// Compute the trajectory point i like computeTrajPt, without marking it as
+// changed, so that several threads can do it at the same time.
+void Road::placeTrajPt(int i)
 {
     Point3f pt, pt1, nor;
     pt = points[i].pt;
@@ -702,20 +865,28 @@ void Road::computeTrajPt(int i)
     pt1 += nor;
     points[i].trjPt = pt1;
 }
+
 // Compute the real value of the trajectory points between start and end indexes
 void Road::computeTrajPts(int start, int end)
 {
-    for (unsigned int i = start; i < end && i < points.size(); i++)
-        computeTrajPt(i);
+    int last = end < points.size() ? end : points.size();
+    if (start >= last)
+        return;
+    parallel_for(start, last, POINT_GRAIN, [this](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            placeTrajPt(i);
+    });
+    trajDirty.mark(start - 1, last + 1);
 }
 
 // Read the trajectory points from a file and interpolate it to match the points we have
 void Road::readTrajFile(char *filename, bool redraw)
 {
+    TRACE_SCOPE("Road::readTrajFile");
     ifstream fin(filename);
     if (!fin.good())
     {
-        cout << "could not read the trajectory from file " << filename << endl;
+        LOG(logError, "could not read the trajectory from file " << filename);
         return;
     }
     float dist1 = 0, dist2, traj1 = 0, traj2, alpha;
@@ -740,7 +911,7 @@ void Road::readTrajFile(char *filename, bool redraw)
                 }
                 computeTrajPt(scan);
                 if (isnan(points[scan].traj))
-                    cout << "nan at " << scan << " dist " << points[scan].dist << endl;
+                    LOG(logWarn, "nan at " << scan << " dist " << points[scan].dist);
                 scan++;
             }
             dist1 = dist2;
@@ -761,16 +932,25 @@ void Road::readTrajFile(char *filename, bool redraw)
 }
 
 // write the stored trajectory in a file for use in Gazelle
-void Road::writeTrajFile(char *filename)
+void Road::writeTrajFile(char *filename) const
 {
+    TRACE_SCOPE("Road::writeTrajFile");
     ofstream fout(filename);
     if (!fout.good())
     {
-        cout << "Could not open the file " << filename << " to write the trajectory" << endl;
+        LOG(logError, "Could not open the file " << filename << " to write the trajectory");
         return;
     }
-    for (unsigned int i = 0; i < points.size(); i++)
-        fout << points[i].dist << "\t" << points[i].traj << endl;
+    // the chunks are formatted at the same time and written in order
+    vector<string> chunks((points.size() + POINT_GRAIN - 1) / POINT_GRAIN);
+    parallel_for(0, points.size(), POINT_GRAIN, [this, &chunks](int begin, int end) {
+        ostringstream out;
+        for (int i = begin; i < end; i++)
+            out << points[i].dist << "\t" << points[i].traj << '\n';
+        chunks[begin / POINT_GRAIN] = out.str();
+    });
+    for (unsigned int c = 0; c < chunks.size(); c++)
+        fout << chunks[c];
     fout.close();
 }
 
@@ -778,37 +958,45 @@ void Road::writeTrajFile(char *filename)
 void Road::setConstTraj(float tr, bool redraw)
 {
     for (unsigned int i = 0; i < points.size(); i++)
-    {
         points[i].traj = tr;
-        computeTrajPt(i);
-    }
+    computeTrajPts(0, points.size());
     // redraw the trajectory
     if (redraw)
         drawTrajFromPoints();
 }
 
 // write the real points of the trajectory together with the real curvature
-void Road::writeRealPts(char *filename)
+void Road::writeRealPts(char *filename) const
 {
+    TRACE_SCOPE("Road::writeRealPts");
     ofstream fout(filename);
     if (!fout.good())
     {
-        cout << "Could not open the file " << filename << " to write the real points" << endl;
+        LOG(logError, "Could not open the file " << filename << " to write the real points");
         return;
     }
-    float realCrv;
-    for (unsigned int i = 0; i < points.size(); i++)
-    {
-        realCrv = realTrajCurv(i);
-        fout << points[i].dist << "\t" << points[i].trjPt << "\t" << realCrv << endl;
-    }
+    // the chunks are formatted at the same time and written in order
+    vector<string> chunks((points.size() + POINT_GRAIN - 1) / POINT_GRAIN);
+    parallel_for(0, points.size(), POINT_GRAIN, [this, &chunks](int begin, int end) {
+        ostringstream out;
+        float realCrv;
+        for (int i = begin; i < end; i++)
+        {
+            realCrv = realTrajCurv(i);
+            out << points[i].dist << "\t" << points[i].trjPt << "\t" << realCrv << '\n';
+        }
+        chunks[begin / POINT_GRAIN] = out.str();
+    });
+    for (unsigned int c = 0; c < chunks.size(); c++)
+        fout << chunks[c];
     fout.close();
 }
 
 // Optimize the trajectory by moving the points along the real curvature direction 
 // while they still remain in the bounds of the road
-void Road::optimizeTraj()
+void Road::optimizeTraj(bool redraw)
 {
+    TRACE_SCOPE("Road::optimizeTraj");
     float realTC;
     //findControlPoints(ctrlPts);
     for (unsigned int i = 1; i < points.size() - 1; i++)
@@ -836,12 +1024,14 @@ void Road::optimizeTraj()
     // recompute the actual points
     computeTrajPts(1, points.size());
     // and redraw the trajectory
-    drawTrajFromPoints();
+    if (redraw)
+        drawTrajFromPoints();
 }
 
 // Averages the values with those around in a given radius.
-void Road::smoothTrajectory(int radius)
+void Road::smoothTrajectory(int radius, bool redraw)
 {
+    TRACE_SCOPE("Road::smoothTrajectory");
     unsigned int i, j;
     float value;
     for (i = radius; i < points.size() - radius; i++)
@@ -857,7 +1047,186 @@ void Road::smoothTrajectory(int radius)
     // recompute the actual points
     computeTrajPts(1, points.size());
     // and redraw the trajectory
-    drawTrajFromPoints();
+    if (redraw)
+        drawTrajFromPoints();
+}
+
+// Store in coarse a copy of the road keeping one point in every stride, 
+// with the curvature averaged over the skipped points.
+void Road::decimate(Road &coarse, int stride) const
+{
+    int n = points.size(), i, j, end;
+    float sumCurv;
+    RoadPt point;
+    coarse.points.clear();
+    coarse.copySettings(*this);
+    for (i = 0; i < n; i += stride) {
+        copyPoint(point, points[i]);
+        // average the curvature like in readStepPointList
+        end = MMIN(i + stride, n);
+        sumCurv = 0;
+        for (j = i; j < end; j++)
+            sumCurv += points[j].curv;
+        point.curv = sumCurv / (end - i);
+        coarse.points.push_back(point);
+    }
+    // always keep the last point so that the coarse road has the same ends
+    if ((n - 1) % stride != 0)
+        coarse.points.push_back(points[n - 1]);
+}
+
+// Set the trajectory by interpolating the one of a road decimated with this stride.
+void Road::prolong(Road &coarse, int stride)
+{
+    int n = points.size(), c, p1, p2;
+    float alpha;
+    for (c = 0; c < coarse.points.size() - 1; c++) {
+        p1 = c * stride;
+        p2 = MMIN((c + 1) * stride, n - 1);
+        for (int i = p1; i < p2; i++) {
+            alpha = float(i - p1) / (p2 - p1);
+            points[i].traj = LINEAR_INTERP(coarse.points[c].traj, coarse.points[c + 1].traj, alpha);
+        }
+    }
+    points[n - 1].traj = coarse.points[coarse.points.size() - 1].traj;
+    computeTrajPts(0, n);
+}
+
+// Optimize the trajectory from coarse to fine: the road is decimated by 2 for each
+// level, the coarsest one gets the given number of passes, and every finer one
+// starts from the interpolated trajectory and refines it with a few passes. 
+// A radius larger than 1 also smooths the trajectory after each pass. The passes
+// are those of optimizeTraj with a step of inc, or of MULTI_INC while inc is 0, its
+// value after init, doubled at each coarser level where the points are twice as far.
+void Road::multiLevelTraj(int levels, int passes, int refine, int radius, bool redraw)
+{
+    TRACE_SCOPE("Road::multiLevelTraj");
+    float saved = inc;
+    if (inc <= 0)
+        inc = MULTI_INC;
+    if (levels > 1 && points.size() > 16) {
+        Road coarse;
+        decimate(coarse, 2);
+        coarse.inc = 2 * inc;
+        coarse.multiLevelTraj(levels - 1, passes, refine, radius / 2, false);
+        prolong(coarse, 2);
+        // the changes have already propagated at the coarse levels
+        passes = refine;
+    }
+    for (int i = 0; i < passes; i++) {
+        optimizeTraj(false);
+        if (radius > 1)
+            smoothTrajectory(radius, false);
+    }
+    inc = saved;
+    if (redraw)
+        drawTrajFromPoints();
+}
+
+// Compute the trajectory of minimum curvature directly, as the solution of a
+// quadratic program in the trajectory values. The bounds are kept by an active set.
+void Road::minCurvTraj(int maxIter, bool redraw)
+{
+    TRACE_SCOPE("Road::minCurvTraj");
+    int n = points.size();
+    if (n < 5 || maxIter < 1)
+        return;
+    // The trajectory point i is pt_i + roadWidth * traj_i * norm_i, and its curvature
+    // is approximated by the divided second difference of the trajectory points, so the
+    // integral of the squared curvature is a quadratic function of traj with a band of
+    // width 2. The steps h are taken on the centerline, and kept away from 0.
+    bool closed = isClosed();
+    int i, k, a, b, iter, idx[3];
+    // a closed road often ends next to its first point: that last point would make a
+    // step of almost 0 and huge weights, so it is left out and takes the first value
+    int nrPts = n;
+    if (closed && points[n - 1].pt.distance(points[0].pt) < 0.5 * points[n - 1].dist / (n - 1))
+        nrPts = n - 1;
+    if (nrPts < 5)
+        return;
+    int first = closed ? 0 : 1, last = closed ? nrPts : n - 1;
+    double coef[3], ax[3], ay[3], ex, ey, h0, h1, hMin, scale, diag = 0;
+    BandMatrix hess(nrPts, 2, closed), system;
+    vector<double> grad(nrPts, 0), rhs(nrPts), x, res;
+    vector<int> bound(nrPts, 0); // -1 or 1 if the point is held at the bound
+    bool changed;
+
+    hMin = 0.01 * points[n - 1].dist / n;
+    for (k = first; k < last; k++) {
+        idx[0] = (k + nrPts - 1) % nrPts;
+        idx[1] = k;
+        idx[2] = (k + 1) % nrPts;
+        h0 = MMAX(points[idx[0]].pt.distance(points[idx[1]].pt), hMin);
+        h1 = MMAX(points[idx[1]].pt.distance(points[idx[2]].pt), hMin);
+        scale = 2 / (h0 + h1) * sqrt(0.5 * (h0 + h1));
+        coef[0] = scale / h0;
+        coef[1] = -scale * (1 / h0 + 1 / h1);
+        coef[2] = scale / h1;
+        ex = ey = 0;
+        for (a = 0; a < 3; a++) {
+            ax[a] = coef[a] * roadWidth * points[idx[a]].norm.x();
+            ay[a] = coef[a] * roadWidth * points[idx[a]].norm.y();
+            ex += coef[a] * points[idx[a]].pt.x();
+            ey += coef[a] * points[idx[a]].pt.y();
+        }
+        for (a = 0; a < 3; a++) {
+            for (b = 0; b < 3; b++)
+                hess.add(idx[a], idx[b], ax[a] * ax[b] + ay[a] * ay[b]);
+            grad[idx[a]] += ax[a] * ex + ay[a] * ey;
+        }
+    }
+    // a slight pull towards the center keeps straight stretches defined
+    for (i = 0; i < nrPts; i++)
+        diag += hess.at(i, 0);
+    diag = 1e-6 * diag / nrPts;
+    for (i = 0; i < nrPts; i++)
+        hess.add(i, i, diag);
+
+    for (iter = 0; iter < maxIter; iter++) {
+        system = hess;
+        for (i = 0; i < nrPts; i++)
+            rhs[i] = -grad[i];
+        for (i = 0; i < nrPts; i++)
+            if (bound[i])
+                system.fixValue(i, bound[i] * MAX_TRAJ, rhs);
+        if (!system.solve(rhs, x)) {
+            LOG(logWarn, "Singular system in the minimum curvature trajectory");
+            return;
+        }
+        // hold the points going out of the road at the bound
+        changed = false;
+        for (i = 0; i < nrPts; i++)
+            if (!bound[i] && fabs(x[i]) > MAX_TRAJ) {
+                bound[i] = x[i] > 0 ? 1 : -1;
+                changed = true;
+            }
+        if (changed)
+            continue;
+        // release the points where the gradient pulls back inside the road
+        hess.multiply(x, res);
+        for (i = 0; i < nrPts; i++)
+            if (bound[i] && (res[i] + grad[i]) * bound[i] > 0) {
+                bound[i] = 0;
+                changed = true;
+            }
+        if (!changed)
+            break;
+    }
+
+    for (i = 0; i < nrPts; i++) {
+        if (x[i] > MAX_TRAJ)
+            x[i] = MAX_TRAJ;
+        else if (x[i] < -MAX_TRAJ)
+            x[i] = -MAX_TRAJ;
+        points[i].traj = x[i];
+    }
+    if (nrPts < n)
+        points[n - 1].traj = points[0].traj;
+    // recompute the actual points
+    computeTrajPts(0, n);
+    // and redraw the trajectory
+    if (redraw)
+        drawTrajFromPoints();
 }
 
 // find the control points of the trajectory, which would be the ones 
@@ -897,12 +1266,16 @@ void Road::findControlPoints(vector<int> &data)
 // where the trajectory curves the most, or the middle of a continuous stretch
 void Road::findKeyFrames()
 {
+    TRACE_SCOPE("Road::findKeyFrames");
     if (points.size() < 3)
         return;
     float c1, c2;
     KeyFrame kf = { 0, 1, 0 };
     bool flat = false;
     int startStr = 0, endStr = 0;
+    version = newVersion(); // the segments evaluated before have other bounds
+    markersDirty = true;
+    trajDirty.mark(0, points.size()); // the colors depend on the keyframes
     keyframes.clear();
     keyframes.push_back(kf);
     c1 = points[0].curv;
@@ -932,8 +1305,8 @@ void Road::findKeyFrames()
                     kf.sign = 1;
                 else
                     kf.sign = -1;
-                cout << keyframes.size() << "\tkey frame:\t" << kf.pt << "\tlength:\t" << kf.length
-                     << "\tsign:\t" << kf.sign << " dist:\t" << points[kf.pt].dist << endl;
+                LOG(logDebug, keyframes.size() << "\tkey frame:\t" << kf.pt << "\tlength:\t" << kf.length
+                     << "\tsign:\t" << kf.sign << " dist:\t" << points[kf.pt].dist);
                 if (kf.pt > 0)
                     keyframes.push_back(kf); 
                 else
@@ -945,7 +1318,7 @@ void Road::findKeyFrames()
             }
         }
     }
-    cout << "Total key frames: " << keyframes.size() << endl;
+    LOG(logInfo, "Total key frames: " << keyframes.size());
 }
 
 // Output the key frames. If they're not computed, compute them first.
@@ -953,6 +1326,7 @@ void Road::outputKeyFrames()
 {
     if (keyframes.size() == 0)
         findKeyFrames();
+    logFlush(); // the messages logged so far come before the table
     cout << "Nr\tKeyframe\tlength\tsign\tdist" << endl;
     for (int i = 0; i < keyframes.size(); i++) {
         cout << i << " " << keyframes[i].pt << " " << keyframes[i].length
@@ -960,10 +1334,34 @@ void Road::outputKeyFrames()
     }
 }
 
+// Write the key frames in a file. If they're not computed, compute them first.
+void Road::writeKeyFrames(char *filename)
+{
+    ofstream fout(filename);
+    if (!fout.good())
+    {
+        LOG(logError, "Could not open the file " << filename << " to write the key frames");
+        return;
+    }
+    if (keyframes.size() == 0)
+        findKeyFrames();
+    fout << "Nr\tKeyframe\tlength\tsign\tdist" << endl;
+    for (int i = 0; i < keyframes.size(); i++) {
+        fout << i << "\t" << keyframes[i].pt << "\t" << keyframes[i].length
+             << "\t" << keyframes[i].sign << "\t" << points[keyframes[i].pt].dist << endl;
+    }
+    fout.close();
+}
+
 // Compute the keyframes as the points where the curvature changes sign.
-void Road::computeCurvChangePts()
+// They are also output unless verbose is false.
+void Road::computeCurvChangePts(bool verbose)
 {
+    TRACE_SCOPE("Road::computeCurvChangePts");
     KeyFrame kf;
+    version = newVersion(); // the segments evaluated before have other bounds
+    markersDirty = true;
+    trajDirty.mark(0, points.size()); // the colors depend on the keyframes
     for (int i = 0; i < points.size(); i++) {
         if (i == 0 || i == points.size() - 1 || points[i - 1].curv * points[i].curv <= 0) {
             kf.pt = i;
@@ -977,15 +1375,17 @@ void Road::computeCurvChangePts()
                 kf.length = 0;
             else
                 kf.length = i - keyframes[keyframes.size() - 1].pt;
-            cout << keyframes.size() << " " << kf.pt << " " << kf.length << " " << kf.sign << endl;
+            if (verbose)
+                LOG(logInfo, keyframes.size() << " " << kf.pt << " " << kf.length << " " << kf.sign);
             keyframes.push_back(kf);
         }
     }
 }
 
 // Output all the points where the trajectory changes sign or it is 0.
-void Road::outputCurvChangePts()
+void Road::outputCurvChangePts() const
 {
+    logFlush();
     for (int i = 0; i < points.size(); i++) {
         if (i == 0 || i == points.size() - 1 || points[i - 1].curv * points[i].curv <= 0)
             cout << i << " " << points[i].dist << " " << points[i].curv << endl;
@@ -993,8 +1393,9 @@ void Road::outputCurvChangePts()
 }
 
 // Output all the points with distance and curvature
-void Road::outputPoints()
+void Road::outputPoints() const
 {
+    logFlush();
     for (int i = 0; i < points.size(); i++) {
         cout << i << " " << points[i].pt << " "
              << points[i].dist << " " << points[i].curv << endl;
@@ -1017,7 +1418,7 @@ void Road::updateMinMax(Point3f &pt, float curv)
 }
 
 // given an index in the points array, computes the curvature of the trajectory
-float Road::realTrajCurv(int i)
+float Road::realTrajCurv(int i) const
 {
     if (i <= 0 || i >= points.size() - 1)
         return 0;
@@ -1037,18 +1438,27 @@ float Road::realTrajCurv(int i)
     else
         sinTau = -sqrt(1 - cosTau*cosTau);
     if (isnan(sinTau))
-        cout << "nan from cos " << cosTau << endl;
+        LOG(logWarn, "nan from cos " << cosTau);
     return sinTau;
 }
 
 // Is the road almost flat at this index?
-bool Road::isFlat(int pt)
+bool Road::isFlat(int pt) const
 {
     return fabs(points[pt].curv) <= almostFlat;
 }
 
+// Is the road a closed track? The last point must be within the width of the road
+// from the first one.
+bool Road::isClosed() const
+{
+    if (points.size() < 3)
+        return false;
+    return points[0].pt.distance(points[points.size() - 1].pt) < roadWidth;
+}
+
 // Find the next anchor assuming that we do have the keyframes computed. 
-void Road::findNextAnchorKF(int &kfStart, int &kfEnd)
+void Road::findNextAnchorKF(int &kfStart, int &kfEnd) const
 {
     kfStart = kfEnd;
     if (kfEnd >= keyframes.size() - 1)
@@ -1066,7 +1476,7 @@ void Road::findNextAnchorKF(int &kfStart, int &kfEnd)
 
 // Find the center of the next stretch where the road is almost flat for a number
 // of points equal to flatLength.
-int Road::findNextAnchor(int start, bool &flat)
+int Road::findNextAnchor(int start, bool &flat) const
 {
     unsigned int first = start, current = start;
     flat = true;
@@ -1098,6 +1508,7 @@ void Road::setTrajectory(double traj[], int size, int startPt, int endPt, int st
 {
     int i, j = 0, k = 0;
     double trj = 0;
+    trajDirty.mark(startPt, endPt);
 
     for (i = startPt; i < endPt; i++)
     {
@@ -1120,6 +1531,7 @@ void Road::setTrajectoryKF(double traj[], int size, int startKF, int endKF, int
 {
     int i = 0, j = 0, k = 0, p1, p2, step;
     double t1, t2, trj = 0;
+    trajDirty.mark(keyframes[startKF].pt, keyframes[endKF].pt + 1);
 
     for (k = startKF; k < endKF; k++)
     {
@@ -1154,6 +1566,9 @@ void Road::setTrajectoryKF(vector<double> traj, int startKF, int endKF, int inte
     double t1, t2, trj = 0;
 
     int size = traj.size();
+    if (startKF < keyframes.size())
+        trajDirty.mark(keyframes[startKF].pt, endKF < keyframes.size() ?
+                       keyframes[endKF].pt + 1 : points.size());
     for (k = startKF; k < endKF && k < keyframes.size(); k++)
     {
         p1 = keyframes[k].pt;
@@ -1190,6 +1605,7 @@ void Road::setTrajectory(vector<double> traj, int startPt, int endPt, int step)
 {
     int i, j = 0, k = 0, size = traj.size();
     double trj = 0;
+    trajDirty.mark(startPt, endPt);
 
     for (i = startPt; i < endPt; i++)
     {
@@ -1207,48 +1623,179 @@ void Road::setTrajectory(vector<double> traj, int startPt, int endPt, int step)
     }
 }
 
-// Calculate the real distance along the trajectory between the start and end points
-double Road::sumDistance(int startPt, int endPt)
+// Store in seg a road made of the points between the indexes start and end, included.
+void Road::extractSegment(int start, int end, Road &seg) const
 {
-    double sum = 0;
-    Point3f prevPt = points[startPt].trjPt, thisPt;
-    for (unsigned int i = startPt+1; i < endPt && i < points.size(); i++)
-    {
-        thisPt = points[i].trjPt;
-        sum += thisPt.distance(prevPt);
-        prevPt = thisPt;
+    seg.copySettings(*this);
+    seg.points.assign(points.begin() + start, points.begin() + end + 1);
+}
+
+// Copy back the trajectory of a segment extracted at the index start. Both ends keep 
+// their current value, and the difference is spread over blend points from each end.
+void Road::stitchSegment(Road &seg, int start, int blend)
+{
+    int last = seg.points.size() - 1, j;
+    if (last < 2)
+        return;
+    float delta0 = points[start].traj - seg.points[0].traj,
+          delta1 = points[start + last].traj - seg.points[last].traj, trj;
+    if (blend < 1)
+        blend = 1;
+    // the ends themselves are shared with the neighbor segments and stay as they are
+    for (j = 1; j < last; j++) {
+        trj = seg.points[j].traj;
+        if (j < blend)
+            trj += delta0 * (blend - j) / blend;
+        if (last - j < blend)
+            trj += delta1 * (blend - last + j) / blend;
+        if (trj > MAX_TRAJ)
+            trj = MAX_TRAJ;
+        else if (trj < -MAX_TRAJ)
+            trj = -MAX_TRAJ;
+        points[start + j].traj = trj;
     }
-    return sum;
+}
+
+// Calculate the real distance along the trajectory between the start and end points.
+// The partial sums are added in the same order whatever the number of threads.
+double Road::sumDistance(int startPt, int endPt) const
+{
+    int last = endPt < points.size() ? endPt : points.size();
+    // the segment from i-1 to i is counted with the point i
+    return parallel_reduce(startPt + 1, last, POINT_GRAIN, 0.0, [this](int begin, int end) {
+        double sum = 0;
+        for (int i = begin; i < end; i++)
+            sum += points[i].trjPt.distance(points[i - 1].trjPt);
+        return sum;
+    }, [](double a, double b) { return a + b; });
 }
 
 // Find the maximum absolute value of the curvature between start and end points
-double Road::findMaxCurv(int startPt, int endPt)
+double Road::findMaxCurv(int startPt, int endPt) const
 {
-    double crv = 0; // it won't be smaller than this
-    for (int i = startPt; i < endPt && i < points.size(); i++)
-        if (fabs(realTrajCurv(i)) > crv)
-            crv = fabs(realTrajCurv(i));
-    return crv;
+    int last = endPt < points.size() ? endPt : points.size();
+    // it won't be smaller than 0
+    return parallel_reduce(startPt, last, POINT_GRAIN, 0.0, [this](int begin, int end) {
+        double crv = 0, rc;
+        for (int i = begin; i < end; i++) {
+            rc = fabs(realTrajCurv(i));
+            if (rc > crv)
+                crv = rc;
+        }
+        return crv;
+    }, [](double a, double b) { return a > b ? a : b; });
 }
 
-// Sum the curvature between start and end points
-double Road::sumCurv(int startPt, int endPt)
+// Sum the curvature between start and end points.
+// The partial sums are added in the same order whatever the number of threads.
+double Road::sumCurv(int startPt, int endPt) const
 {
-    double crv = 0, rc = 0, crv1 = 0; // it won't be larger than this
-    for (unsigned int i = startPt; i < endPt && i < points.size(); i++)
-    {
-        rc = realTrajCurv(i);
-        crv += fabs(rc);
-        if (isnan(crv))
-            cout << "nan at point " << i << " real curv: " << rc << endl;
-        crv1 = crv;
+    int last = endPt < points.size() ? endPt : points.size();
+    return parallel_reduce(startPt, last, POINT_GRAIN, 0.0, [this](int begin, int end) {
+        double crv = 0, rc;
+        for (int i = begin; i < end; i++)
+        {
+            rc = realTrajCurv(i);
+            crv += fabs(rc);
+            if (isnan(crv))
+                LOG(logWarn, "nan at point " << i << " real curv: " << rc);
+        }
+        return crv;
+    }, [](double a, double b) { return a + b; });
+}
+
+// Compute the length and the sum of curvature of the trajectory between the start
+// and end points like sumDistance and sumCurv, and keep the term of each point
+// so that local changes can be scored again with rescoreTraj.
+void Road::scoreTraj(int startPt, int endPt)
+{
+    TRACE_SCOPE("Road::scoreTraj");
+    int n = points.size();
+    scoreStart = startPt > 0 ? startPt : 0;
+    scoreEnd = endPt < n ? endPt : n;
+    scoreVersion = version;
+    distTerm.assign(n, 0);
+    curvTerm.assign(n, 0);
+    totalDist = totalCurv = 0;
+    parallel_for(scoreStart, scoreEnd, POINT_GRAIN, [this](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            if (i > scoreStart)
+                distTerm[i] = points[i].trjPt.distance(points[i - 1].trjPt);
+            curvTerm[i] = fabs(realTrajCurv(i));
+        }
+    });
+    for (int i = scoreStart; i < scoreEnd; i++) {
+        totalDist += distTerm[i];
+        totalCurv += curvTerm[i];
+    }
+}
+
+// After the trajectory values changed between the start and end indexes, recompute 
+// the trajectory points there and update totalDist and totalCurv with the new terms 
+// of these points and of one point on each side. Costs O(end - start). If the terms
+// were not computed by scoreTraj for this version of the road, it scores it all.
+void Road::rescoreTraj(int start, int end)
+{
+    int i, first, last, n = points.size();
+    start = MMAX(start, 0);
+    end = MMIN(end, n);
+    if (start >= end)
+        return;
+    computeTrajPts(start, end);
+    if (scoreVersion != version || distTerm.size() != n || curvTerm.size() != n) {
+        scoreTraj(0, n);
+        return;
+    }
+    // the segment from i-1 to i belongs to i, so end is also affected
+    first = MMAX(start, scoreStart + 1);
+    last = MMIN(end + 1, scoreEnd);
+    for (i = first; i < last; i++) {
+        totalDist -= distTerm[i];
+        distTerm[i] = points[i].trjPt.distance(points[i - 1].trjPt);
+        totalDist += distTerm[i];
+    }
+    // the curvature depends on the points on both sides
+    first = MMAX(start - 1, scoreStart);
+    for (i = first; i < last; i++) {
+        totalCurv -= curvTerm[i];
+        curvTerm[i] = fabs(realTrajCurv(i));
+        totalCurv += curvTerm[i];
+    }
+}
+
+// Evaluate the trajectory coded by traj between the keyframes startKF and endKF 
+// as in setTrajectoryKF: its length and its sum of curvature, inside the segment
+// so that they only depend on traj. With a cache, a segment already evaluated 
+// with the same genes isn't computed again. Either way, the road trajectory is
+// set from traj on the segment.
+void Road::evalSegmentKF(vector<double> &traj, int startKF, int endKF, int interm,
+                         double &dist, double &curv, FitnessCache *cache)
+{
+    TRACE_SCOPE("Road::evalSegmentKF");
+    int p1 = keyframes[startKF].pt, p2;
+    if (endKF < keyframes.size())
+        p2 = keyframes[endKF].pt;
+    else
+        p2 = points.size() - 1;
+    // the points from p1 to p2-1 are the ones set from this slice of traj
+    setTrajectoryKF(traj, startKF, endKF, interm);
+    computeTrajPts(p1, p2);
+    FitnessKey key;
+    if (cache) {
+        key = FitnessCache::makeKey(traj, startKF, endKF, interm, version);
+        if (cache->find(key, dist, curv))
+            return;
     }
-    return crv;
+    dist = sumDistance(p1, p2);
+    curv = sumCurv(p1 + 1, p2 - 1);
+    if (cache)
+        cache->insert(key, dist, curv);
 }
 
 // Scale the trajectory uniformly by a scale factor.
 void Road::scaleTraj(float scaleFactor)
 {
+    version = newVersion();
     // the norm, curvature, and trajectory should stay the same
     for (int i = 0; i < points.size(); i++) {
         points[i].pt *= scaleFactor;
@@ -1262,6 +1809,7 @@ void Road::scaleTraj(float scaleFactor)
 // Translate the trajectory uniformly by a vector.
 void Road::translateTraj(Point3f vect)
 {
+    version = newVersion();
     // the norm, curvature, distance, and trajectory should stay the same
     for (int i = 0; i < points.size(); i++) {
         points[i].pt += vect;
@@ -1274,6 +1822,7 @@ void Road::translateTraj(Point3f vect)
 // Set the starting point of the trajectory by moving it along x. 
 void Road::setStartingX(float stx)
 {
+    version = newVersion();
     float diff = stx - points[0].pt.x();
     points[0].pt[0] = stx;
     points[points.size() - 1].pt[0] += diff;
@@ -19,12 +19,28 @@ using namespace std;
 #include "point3f.h"
 #include <cmath>
 #include "roadPt.h"
+#include "vertexBuffer.h"
+#include "lodStrip.h"
+#include "meshCache.h"
 
 #define MAX_TRAJ 0.8
 
+class FitnessCache;
+
 // need to be able to move the data around
 void copyPoint(RoadPt &pt1, RoadPt pt2);
 
+// The distance and curvature pairs of a road file, as they were read, so that
+// the road can be built again with other settings without reading the file.
+// The distances are doubles so that the steps stay exact on long roads.
+struct CurvData {
+    vector<double> dist;
+    vector<float> curv;
+};
+
+// Read all the pairs of distance and curvature from the file.
+void readCurvData(ifstream &fin, CurvData &data);
+
 struct KeyFrame {
     int pt;
     int length;
@@ -33,9 +49,25 @@ struct KeyFrame {
 
 enum RoadType {allScale, skipStep};
 
+// How the trajectory is colored when it's drawn.
+enum TrajColorMode {curvAgreeColor, curvHeatColor, ctrlPtColor, keyFrameColor, nrColorModes};
+
+// A road keeps all its state in its members: different roads can be read,
+// optimized and written by different threads at the same time. The const
+// functions only read the road, so several threads can call them on the same
+// road as long as none of them changes it. The functions drawing with OpenGL
+// must be called from the thread of the window.
 class Road {
 private:
-    int roadId, trajId; // ids for the display lists
+    int roadId; // id for the display list of a road drawn from a file
+    VertexBuffer roadBuf, trajBuf; // vertices of the road and of the trajectory
+    LodStrip roadLod, trajLod;     // their chunks and levels of detail
+    MeshBatch keyMarkers, ctrlMarkers; // spheres on the keyframes and control points
+    bool markersDirty; // the markers have to be placed again
+
+    // Compute the trajectory point i like computeTrajPt, without marking it as
+    // changed, so that several threads can do it at the same time.
+    void placeTrajPt(int i);
 
 public:
     Point3f min, max; // corners of the bounding box
@@ -54,10 +86,22 @@ public:
     int curveLength;  // the count of curve points in one direction to assign an anchor
     bool hasWidth, hasTraj;
     RoadType rdType;
+    TrajColorMode colorMode; // coloring of the trajectory
+    bool showMarkers;        // draw the keyframes and control points as spheres
+    unsigned int version; // changes every time the road itself is read or transformed, or
+                          // its keyframes or settings change, and is never the same for
+                          // two roads built separately
 
     vector<RoadPt> points;
     vector<int> ctrlPts;
     vector<KeyFrame> keyframes;
+    DirtyRange trajDirty; // trajectory points changed since the last drawing
+
+    // contribution of each point to the score of the trajectory kept by scoreTraj
+    vector<double> distTerm, curvTerm;
+    double totalDist, totalCurv; // sums of the terms between scoreStart and scoreEnd
+    int scoreStart, scoreEnd;
+    unsigned int scoreVersion; // version of the road the terms were computed for
 
     // constructor from a file
     Road(char *filename = NULL);
@@ -80,14 +124,24 @@ public:
     // Initialize settings from a dictionary 
     void init(char **aDict, int nOpt);
 
+    // Copy the settings of another road, but not its points.
+    void copySettings(const Road &other);
+
     // set the values of a particular point
     void setPt(int i, float d, Point3f &p, float c);
 
-    // Call the display list.
-    void display();
+    // Draw the vertex buffers, or call the display list if the road was drawn from a file.
+    // Only the parts inside the view from viewMin to viewMax are drawn, with the level
+    // of detail matching the size of a pixel.
+    void display(Point3f &viewMin, Point3f &viewMax, float pixel);
 
     ////////////////////////// Draw //////////////////////////////
 
+    // Place a sphere on the trajectory at every keyframe and control point,
+    // with a radius of half the width of the road, so that they don't change
+    // with the zoom.
+    void drawMarkers();
+
     // To be reimplemented for this class.
     void draw(char *filename);
     // To be reimplemented for this class.
@@ -95,16 +149,28 @@ public:
 
     // Draw from the list of points already stored.
     void draw();
-    // Create the display list from a list of points already stored. 
+    // Fill the road vertex buffer from a list of points already stored. 
     // Display the road as a line
     void drawLineFromPoints();
-    // Create the display list from a list of points already stored. 
+    // Fill the road vertex buffer from a list of points already stored. 
     // Display the road as a ribbon
     void drawRibbonFromPoints();
 
-    // set the color of the trajectory based on various options
-    void setTrajColor(int i, GLfloat &red, GLfloat &blue);
-    // Create the display list from the stored trajectory 
+    // Store the vertices of the centerline in buf as a line strip.
+    void fillLineVertices(VertexBuffer &buf) const;
+    // Store the vertices of the road in buf as a triangle strip.
+    void fillRibbonVertices(VertexBuffer &buf) const;
+
+    // Change the coloring of the trajectory and draw it again.
+    void setColorMode(TrajColorMode mode);
+    // Store the vertices of the whole trajectory in buf as a line strip.
+    void fillTrajVertices(VertexBuffer &buf) const;
+    // Set the vertices of the trajectory points from first to last, not included, 
+    // in buf, which must already have a vertex for every point. The colors of all 
+    // the points are computed at once by the color stage.
+    void setTrajVertices(VertexBuffer &buf, int first, int last) const;
+    // Fill the trajectory vertex buffer from the stored trajectory. If only some 
+    // points changed since the last call, only their vertices are sent again.
     void drawTrajFromPoints();
 
     // Read the data from the file, calculate and draw the points 
@@ -141,19 +207,27 @@ public:
     // then calculate and store the points 
     void readStepPointList(ifstream &fin, float startPt, float endPt);
 
+    // Calculate and store the points from the data between startPt and endPt,
+    // with the scales of the road.
+    void buildPointList(const CurvData &data, float startPt, float endPt);
+
+    // Calculate and store the points from the data using a step, storing only 1
+    // in a number.
+    void buildStepPointList(const CurvData &data, float startPt, float endPt);
+
     // Read the trajectory points from a file and interpolate it to match the points we have
     void readTrajFile(char *filename, bool redraw = true);
 
     ////////////////////////// Write to file ////////////////////
 
     // write the stored trajectory in a file for use in Gazelle
-    void writeTrajFile(char *filename);
+    void writeTrajFile(char *filename) const;
 
     // set the trajectory as a constant
     void setConstTraj(float tr = 0.0, bool redraw = true);
 
     // write the real points of the trajectory together with the real curvature
-    void writeRealPts(char *filename);
+    void writeRealPts(char *filename) const;
 
     ////////////////////////// Trajectory computing ///////////////////////////
 
@@ -166,10 +240,30 @@ public:
 
     // Optimize the trajectory by moving the points along the real curvature direction 
     // while they still remain in the bounds of the road
-    void optimizeTraj();
+    void optimizeTraj(bool redraw = true);
 
     // Averages the values with those around in a given radius.
-    void smoothTrajectory(int radius);
+    void smoothTrajectory(int radius, bool redraw = true);
+
+    // Store in coarse a copy of the road keeping one point in every stride, 
+    // with the curvature averaged over the skipped points.
+    void decimate(Road &coarse, int stride) const;
+
+    // Set the trajectory by interpolating the one of a road decimated with this stride.
+    void prolong(Road &coarse, int stride);
+
+    // Optimize the trajectory from coarse to fine: the road is decimated by 2 for each
+    // level, the coarsest one gets the given number of passes, and every finer one
+    // starts from the interpolated trajectory and refines it with a few passes. 
+    // A radius larger than 1 also smooths the trajectory after each pass. The passes
+    // are those of optimizeTraj with a step of inc, or of a step of its own while inc
+    // is 0, its value after init, doubled at each coarser level.
+    void multiLevelTraj(int levels, int passes, int refine = 1, int radius = 0, 
+                        bool redraw = true);
+
+    // Compute the trajectory of minimum curvature directly, as the solution of a
+    // quadratic program in the trajectory values. The bounds are kept by an active set.
+    void minCurvTraj(int maxIter = 30, bool redraw = true);
 
     // find the control points of the trajectory, which would be the ones 
     // where the trajectory curves the most, or the middle of a continuous stretch
@@ -183,31 +277,39 @@ public:
     void outputKeyFrames();
 
     // Output all the points where the trajectory changes sign or it is 0.
-    void outputCurvChangePts();
+    void outputCurvChangePts() const;
     
+    // Write the key frames in a file. If they're not computed, compute them first.
+    void writeKeyFrames(char *filename);
+
     // Compute the keyframes as the points where the curvature changes sign.
-    void computeCurvChangePts();
+    // They are also output unless verbose is false.
+    void computeCurvChangePts(bool verbose = true);
 
     // Output all the points with distance and curvature
-    void outputPoints();
+    void outputPoints() const;
 
     // update the boudaries points so that we know how to draw the road
     void updateMinMax(Point3f &pt, float curv);
 
     // given an index in the points array, computes the curvature of the trajectory
-    float realTrajCurv(int i);
+    float realTrajCurv(int i) const;
 
     // Is the road almost flat at this index?
-    bool isFlat(int pt);
+    bool isFlat(int pt) const;
+
+    // Is the road a closed track? The last point must be within the width of the road
+    // from the first one.
+    bool isClosed() const;
 
     ////////////////////////// GA-based Trajectory ///////////////////////////
     
     // Find the next anchor assuming that we do have the keyframes computed. 
-    void findNextAnchorKF(int &kfStart, int &kfEnd);
+    void findNextAnchorKF(int &kfStart, int &kfEnd) const;
 
     // Find the center of the next stretch where the road is almost flat for a number
     // of points equal to flatLength.
-    int findNextAnchor(int start, bool &flat);
+    int findNextAnchor(int start, bool &flat) const;
 
     // Set the trajectory between start and end points with given density
     void setTrajectory(double traj[], int size, int startPt, int endPt, int step);
@@ -222,14 +324,40 @@ public:
     // Set the trajectory between start and end points with given density
     void setTrajectory(vector<double> traj, int startPt, int endPt, int step);
 
+    // Store in seg a road made of the points between the indexes start and end, included.
+    void extractSegment(int start, int end, Road &seg) const;
+
+    // Copy back the trajectory of a segment extracted at the index start. Both ends keep 
+    // their current value, and the difference is spread over blend points from each end.
+    void stitchSegment(Road &seg, int start, int blend);
+
     // Calculate the real distance along the trajectory between the start and end points
-    double sumDistance(int startPt, int endPt);
+    double sumDistance(int startPt, int endPt) const;
 
     // Find the maximum absolute value of the curvature between start and end points
-    double findMaxCurv(int startPt, int endPt);
+    double findMaxCurv(int startPt, int endPt) const;
 
     // Sum the curvature between start and end points
-    double sumCurv(int startPt, int endPt);
+    double sumCurv(int startPt, int endPt) const;
+
+    // Compute the length and the sum of curvature of the trajectory between the start
+    // and end points like sumDistance and sumCurv, and keep the term of each point
+    // so that local changes can be scored again with rescoreTraj.
+    void scoreTraj(int startPt, int endPt);
+
+    // After the trajectory values changed between the start and end indexes, recompute 
+    // the trajectory points there and update totalDist and totalCurv with the new terms 
+    // of these points and of one point on each side. Costs O(end - start). If the terms
+    // were not computed by scoreTraj for this version of the road, it scores it all.
+    void rescoreTraj(int start, int end);
+
+    // Evaluate the trajectory coded by traj between the keyframes startKF and endKF 
+    // as in setTrajectoryKF: its length and its sum of curvature, inside the segment
+    // so that they only depend on traj. With a cache, a segment already evaluated 
+    // with the same genes isn't computed again. Either way, the road trajectory is
+    // set from traj on the segment.
+    void evalSegmentKF(vector<double> &traj, int startKF, int endKF, int interm,
+                       double &dist, double &curv, FitnessCache *cache = NULL);
 
     ////////////////////////// Trajectory Transformation ///////////////////////////
     
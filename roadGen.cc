@@ -0,0 +1,262 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    roadGen.cc
+   Updated: October 2026
+
+   A generator of synthetic roads of any size, made of straights and
+   corners with clothoid transitions, written as curvature files or
+   centerline files without keeping the road in memory.
+
+**********************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include "roadGen.h"
+#include "road.h"
+#include "log.h"
+
+#define HAIRPIN_RATE 0.08 // fraction of the corners that are hairpins
+#define S_BEND_RATE 0.3   // fraction of the corners followed directly by another one
+#define LONG_RATE 0.15    // fraction of the straights that are long
+
+// Constructor with the seed of the random numbers and the distance between
+// the points. The same seed always gives the same road.
+RoadGen::RoadGen(unsigned int seed, double step)
+    : random(seed)
+{
+    this->step = step;
+    corner = true; // start with a straight
+    nrPieces = 0;
+    piece = 0;
+    pos = 0;
+}
+
+// A random number between a and b.
+double RoadGen::uniform(double a, double b)
+{
+    return a + (b - a) * (random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Choose the next straight or corner.
+void RoadGen::nextPart()
+{
+    double radius, angle, ramp, curv;
+    piece = 0;
+    if (corner && uniform(0, 1) >= S_BEND_RATE) {
+        // a straight, with an exponential length, or a long one
+        corner = false;
+        nrPieces = 1;
+        pieces[0].start = pieces[0].end = 0;
+        if (uniform(0, 1) < LONG_RATE)
+            pieces[0].length = uniform(300, 1500);
+        else
+            pieces[0].length = 5 - 80 * log(1 - uniform(0, 1));
+        return;
+    }
+    // a corner to the left or to the right
+    if (uniform(0, 1) < HAIRPIN_RATE) {
+        radius = uniform(8, 20);
+        angle = uniform(150, 190) * M_PI / 180;
+        ramp = uniform(5, 15);
+    }
+    else {
+        radius = 25 * exp(uniform(0, log(20.0))); // from 25 to 500
+        angle = uniform(15, 110) * M_PI / 180;
+        ramp = uniform(15, 80);
+    }
+    curv = uniform(0, 1) < 0.5 ? 1 / radius : -1 / radius;
+    // each clothoid turns by curv * ramp / 2
+    if (ramp / radius > angle)
+        ramp = angle * radius;
+    corner = true;
+    nrPieces = 3;
+    pieces[0].start = 0;
+    pieces[0].end = pieces[1].start = pieces[1].end = pieces[2].start = curv;
+    pieces[2].end = 0;
+    pieces[0].length = pieces[2].length = ramp;
+    pieces[1].length = (angle - ramp / radius) * radius;
+}
+
+// The curvature (1 / radius, positive to the left) at the next point.
+double RoadGen::next()
+{
+    while (piece >= nrPieces || pos >= pieces[piece].length) {
+        if (piece < nrPieces) {
+            pos -= pieces[piece].length;
+            piece++;
+        }
+        if (piece >= nrPieces) {
+            nextPart();
+            if (pos < 0)
+                pos = 0;
+        }
+    }
+    Piece &p = pieces[piece];
+    double curv = p.start + (p.end - p.start) * pos / p.length;
+    pos += step;
+    return curv;
+}
+
+// Go along the road generated from the seed for nrSteps steps, with extraCurv
+// added to the curvature, and call visit with the index, the position and the
+// heading of each point, starting from the origin.
+template <class Visit>
+static void walkRoad(unsigned int seed, double step, long long nrSteps, double extraCurv,
+                     Visit visit)
+{
+    RoadGen gen(seed, step);
+    double x = 0, y = 0, heading = 0, curv;
+    visit(0, x, y, heading);
+    for (long long i = 1; i <= nrSteps; i++) {
+        curv = gen.next() + extraCurv;
+        x += step * cos(heading + curv * step / 2);
+        y += step * sin(heading + curv * step / 2);
+        heading += curv * step;
+        visit(i, x, y, heading);
+    }
+}
+
+// Write a road of nrPoints points spaced by step in a file, generated from the
+// seed. A centerline file has the number of points and the length, then x y
+// for each point; a curvature file has the distance and the curvature of each
+// point, scaled like the files read by Road::read. A closed road turns by a full
+// circle and ends where it started; its points are moved for that, so they are
+// only about step apart. Returns false if the file cannot be written.
+bool writeGenRoad(const char *filename, long long nrPoints, double step,
+                  unsigned int seed, bool closed, bool center)
+{
+    long long nrSteps = closed ? nrPoints : nrPoints - 1;
+    double extraCurv = 0, driftX = 0, driftY = 0;
+    double x1 = 0, y1 = 0, x2 = 0, y2 = 0; // the two previous points
+    double length = (nrPoints - 1) * step, along = 0;
+    char line[100];
+    Road settings; // the scales of the curvature when it's read
+    if (nrPoints < 3 || step <= 0)
+        return false;
+    ofstream fout(filename);
+    if (!fout.good())
+        return false;
+
+    if (closed) {
+        // the curvature is shifted so that the road turns by a full circle, then
+        // the distance between the ends is spread over all the points
+        double turn = 0;
+        walkRoad(seed, step, nrSteps, 0, [&](long long, double, double, double h) {
+            turn = h;
+        });
+        extraCurv = ((turn < 0 ? -2 : 2) * M_PI - turn) / (nrSteps * step);
+        walkRoad(seed, step, nrSteps, extraCurv, [&](long long, double x, double y, double) {
+            driftX = x;
+            driftY = y;
+        });
+        // the points are not spaced by step anymore
+        length = 0;
+        walkRoad(seed, step, nrSteps, extraCurv, [&](long long i, double x, double y, double) {
+            x -= driftX * i / nrSteps;
+            y -= driftY * i / nrSteps;
+            if (i > 0 && i < nrPoints)
+                length += sqrt((x - x1) * (x - x1) + (y - y1) * (y - y1));
+            x1 = x;
+            y1 = y;
+        });
+    }
+
+    if (center)
+        fout << nrPoints << " " << length << "\n";
+    x1 = y1 = 0;
+    walkRoad(seed, step, nrSteps, extraCurv, [&](long long i, double x, double y, double) {
+        x -= driftX * i / nrSteps;
+        y -= driftY * i / nrSteps;
+        if (center) {
+            if (i < nrPoints) {
+                snprintf(line, sizeof(line), "%.4f %.4f\n", x, y);
+                fout << line;
+            }
+        }
+        else if (i >= 2) {
+            // the turn at the previous point, as the sine of the angle between the
+            // segments, positive to the right and divided by the reading scale
+            double ax = x1 - x2, ay = y1 - y2, bx = x - x1, by = y - y1;
+            double lenA = sqrt(ax * ax + ay * ay);
+            double sinTau = (ax * by - ay * bx) / (lenA * sqrt(bx * bx + by * by));
+            double curv = sinTau > 0 ? -sinTau / settings.leftScale
+                          : sinTau < 0 ? -sinTau / settings.roadScale : 0;
+            along += lenA;
+            snprintf(line, sizeof(line), "%.4f\t%.6g\n", along, curv);
+            fout << line;
+        }
+        else if (i == 0)
+            fout << "0\t0\n";
+        x2 = x1;
+        y2 = y1;
+        x1 = x;
+        y1 = y;
+    });
+    if (!center && !closed) {
+        snprintf(line, sizeof(line), "%.4f\t0\n", length);
+        fout << line;
+    }
+    fout.close();
+    return !fout.fail();
+}
+
+// Output the options of the generator.
+static void genUsage()
+{
+    cout << "Usage: roadviz gen [options] file" << endl
+         << "  -n points    number of points (default 100000)" << endl
+         << "  -step s      distance between the points (default 0.2)" << endl
+         << "  -seed n      seed of the random numbers (default 1)" << endl
+         << "  -closed      the road ends where it starts" << endl
+         << "  -center      write the centerline points instead of the curvature" << endl;
+}
+
+// Main function of the generator, called with the arguments after "gen".
+int genMain(int argc, char **argv)
+{
+    long long nrPoints = 100000;
+    double step = 0.2;
+    unsigned int seed = 1;
+    bool closed = false, center = false;
+    const char *filename = NULL;
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "-closed"))
+            closed = true;
+        else if (!strcmp(argv[i], "-center"))
+            center = true;
+        else if (argv[i][0] != '-' && !filename)
+            filename = argv[i];
+        else if (i + 1 < argc && !strcmp(argv[i], "-n"))
+            nrPoints = atoll(argv[++i]);
+        else if (i + 1 < argc && !strcmp(argv[i], "-step"))
+            step = atof(argv[++i]);
+        else if (i + 1 < argc && !strcmp(argv[i], "-seed"))
+            seed = strtoul(argv[++i], NULL, 10);
+        else {
+            genUsage();
+            return 2;
+        }
+    }
+    if (!filename || nrPoints < 3 || step <= 0) {
+        genUsage();
+        return 2;
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool written = writeGenRoad(filename, nrPoints, step, seed, closed, center);
+    logFlush(); // the messages of the generation come before the summary
+    if (!written) {
+        cout << "Could not write the road in " << filename << endl;
+        return 1;
+    }
+    cout << "Wrote " << nrPoints << " points in " << filename << " in "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count()
+         << " seconds" << endl;
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    roadGen.h
+   Updated: October 2026
+
+   A generator of synthetic roads of any size, made of straights and
+   corners with clothoid transitions, written as curvature files or
+   centerline files without keeping the road in memory.
+
+**********************************************************************/
+
+#ifndef ROAD_GEN_H
+#define ROAD_GEN_H
+
+#include <random>
+using namespace std;
+
+// The curvature of a random road, one point after the other. The road
+// alternates straights, some of them long, and corners: a clothoid where the
+// curvature grows linearly, an arc, and a clothoid back to straight. Some
+// corners are hairpins, and some follow each other as S bends.
+class RoadGen {
+public:
+    // Constructor with the seed of the random numbers and the distance between
+    // the points. The same seed always gives the same road.
+    RoadGen(unsigned int seed, double step);
+
+    // The curvature (1 / radius, positive to the left) at the next point.
+    double next();
+
+private:
+    // A piece of the road where the curvature changes linearly.
+    struct Piece {
+        double start, end; // curvature at both ends
+        double length;
+    };
+
+    mt19937_64 random;
+    double step;
+    Piece pieces[3];     // the pieces of the current straight or corner
+    int nrPieces, piece; // how many, and the one the next point is on
+    double pos;          // distance of the next point from the start of the piece
+    bool corner;         // the current pieces are a corner
+
+    // A random number between a and b.
+    double uniform(double a, double b);
+
+    // Choose the next straight or corner.
+    void nextPart();
+};
+
+// Write a road of nrPoints points spaced by step in a file, generated from the
+// seed. A centerline file has the number of points and the length, then x y
+// for each point; a curvature file has the distance and the curvature of each
+// point, scaled like the files read by Road::read. A closed road turns by a full
+// circle and ends where it started; its points are moved for that, so they are
+// only about step apart. Returns false if the file cannot be written.
+bool writeGenRoad(const char *filename, long long nrPoints, double step,
+                  unsigned int seed, bool closed, bool center);
+
+// Main function of the generator, called with the arguments after "gen".
+int genMain(int argc, char **argv);
+
+#endif
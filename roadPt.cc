@@ -23,7 +23,7 @@ using namespace std;
 
 // Assign values to the target object based on the 
 // linear interpolation of the two parameters.
-void RoadPt::linearInterpolate(RoadPt& pt1, RoadPt &pt2, float alpha)
+void RoadPt::linearInterpolate(const RoadPt& pt1, const RoadPt &pt2, float alpha)
 {
     pt[0] = LINEAR_INTERP(pt1.pt[0], pt2.pt[0], alpha);
     pt[1] = LINEAR_INTERP(pt1.pt[1], pt2.pt[1], alpha);
@@ -38,17 +38,20 @@ void RoadPt::linearInterpolate(RoadPt& pt1, RoadPt &pt2, float alpha)
 
 // Assign values to the target object based on the 
 // quadratic interpolation of the two parameters, using the tangent as extra constraint.
-void RoadPt::quadraticInterpolate(RoadPt& pt1, RoadPt& pt2, float alpha)
+// The polynomials are computed in curve when alpha is 0 and reused for the other values.
+void RoadPt::quadraticInterpolate(const RoadPt& pt1, const RoadPt& pt2, float alpha,
+                                  QuadCurve &curve)
 {
-    static Point3f t1, t2;
-    static float a0, a1, a2, b0, b1, b2; 
+    float &a0 = curve.a0, &a1 = curve.a1, &a2 = curve.a2,
+          &b0 = curve.b0, &b1 = curve.b1, &b2 = curve.b2;
     // compute the polynomial again for alpha == 0
     if (alpha == 0) {
-        t1.set_data(pt1.norm[1], -pt1.norm[0], 0);
-        t2.set_data(pt2.norm[1], -pt2.norm[0], 0);
+        Point3f t1(pt1.norm[1], -pt1.norm[0], 0), t2(pt2.norm[1], -pt2.norm[0], 0);
         a0 = pt1.pt[0];
         b0 = pt1.pt[1];
-        if (t1[0] == 0 && t2[0] == 0 || t1[1] == 0 && t2[1] == 0)
+        curve.linear = (t1[0] == 0 && t2[0] == 0) || (t1[1] == 0 && t2[1] == 0) ||
+                       (t1[1] != 0 && t1[1] * t2[0] - 2 * t1[0] * t2[1] == 0);
+        if (curve.linear)
             return linearInterpolate(pt1, pt2, alpha);
         if (t1[1] == 0) {
             b1 = 0;
@@ -57,19 +60,16 @@ void RoadPt::quadraticInterpolate(RoadPt& pt1, RoadPt& pt2, float alpha)
             a2 = pt2.pt[0] - a0 - a1;
         }
         else {
-            if (t1[1] * t2[0] - 2 * t1[0] * t2[1] == 0) {
-                // no solution, fall back to linear
-                return linearInterpolate(pt1, pt2, alpha);
-            }
-            else {
-                b1 = (2 * a0 * t2[1] - 2 * pt2.pt[0] * t2[1] - 2 * b0 * t2[0] + 2 * pt2.pt[1] * t2[0])
-                    * t1[1] / (t1[1] * t2[0] - 2 * t1[0] * t2[1]);
-                b2 = pt2.pt[1] - b0 - b1;
-                a1 = b1 * t1[0] / t1[1];
-                a2 = pt2.pt[0] - a0 - a1;
-            }
+            b1 = (2 * a0 * t2[1] - 2 * pt2.pt[0] * t2[1] - 2 * b0 * t2[0] + 2 * pt2.pt[1] * t2[0])
+                * t1[1] / (t1[1] * t2[0] - 2 * t1[0] * t2[1]);
+            b2 = pt2.pt[1] - b0 - b1;
+            a1 = b1 * t1[0] / t1[1];
+            a2 = pt2.pt[0] - a0 - a1;
         }
     }
+    // no solution for this pair of points, fall back to linear
+    else if (curve.linear)
+        return linearInterpolate(pt1, pt2, alpha);
     // now we can compute the point
     pt[0] = a0 + a1 * alpha + a2 * alpha * alpha;
     pt[1] = b0 + b1 * alpha + b2 * alpha * alpha;
@@ -21,6 +21,15 @@
 
 enum InterpType {none, linear, quadr, cubic};
 
+// The polynomials of the quadratic curve from one road point to the next,
+// x = a0 + a1 t + a2 t^2 and y = b0 + b1 t + b2 t^2 for t from 0 to 1.
+// Each caller keeps its own, so that several roads can be interpolated
+// at the same time.
+struct QuadCurve {
+    float a0, a1, a2, b0, b1, b2;
+    bool linear; // no curve matches the tangents, the points are interpolated linearly
+};
+
 class RoadPt {
 public:
     float dist;
@@ -30,10 +39,12 @@ public:
 
     // Assign values to the target object based on the 
     // linear interpolation of the two parameters.
-    void linearInterpolate(RoadPt& pt1, RoadPt &pt2, float alpha);
+    void linearInterpolate(const RoadPt& pt1, const RoadPt &pt2, float alpha);
     // Assign values to the target object based on the 
     // quadratic interpolation of the two parameters, using the tangent as extra constraint.
-    void quadraticInterpolate(RoadPt& pt1, RoadPt& pt2, float alpha);
+    // The polynomials are computed in curve when alpha is 0 and reused for the other values.
+    void quadraticInterpolate(const RoadPt& pt1, const RoadPt& pt2, float alpha,
+                              QuadCurve &curve);
 
     // need to be able to move the data around
     friend void copyPoint(RoadPt& pt1, RoadPt pt2);
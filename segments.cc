@@ -0,0 +1,103 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    segments.cc
+   Updated: October 2026
+
+   Optimization of the trajectory on segments of the road between
+   anchors, running in parallel.
+
+**********************************************************************/
+
+#include "segments.h"
+#include "trajDP.h"
+#include "trace.h"
+
+// Engine running a number of passes of optimizeTraj.
+SegmentEngine optimizeEngine(int passes)
+{
+    return [passes](Road &seg) {
+        for (int i = 0; i < passes; i++)
+            seg.optimizeTraj(false);
+    };
+}
+
+// Engine running a number of passes of smoothTrajectory.
+SegmentEngine smoothEngine(int radius, int passes)
+{
+    return [radius, passes](Road &seg) {
+        if (seg.points.size() <= 2 * radius)
+            return;
+        for (int i = 0; i < passes; i++)
+            seg.smoothTrajectory(radius, false);
+    };
+}
+
+// Engine solving for the minimum curvature trajectory.
+SegmentEngine minCurvEngine()
+{
+    return [](Road &seg) {
+        seg.minCurvTraj(30, false);
+    };
+}
+
+// Engine running the dynamic programming over a grid of lanes.
+SegmentEngine gridEngine(int lanes, int stride)
+{
+    return [lanes, stride](Road &seg) {
+        TrajDP dp(lanes, stride);
+        dp.optimize(seg, false);
+    };
+}
+
+// Find the anchors splitting the road, starting with 0 and ending with the
+// last point, with the centers of the flat stretches found by findNextAnchor
+// in between.
+void findAnchors(Road &rd, vector<int> &anchors)
+{
+    int last = rd.points.size() - 1, next;
+    bool flat;
+    anchors.clear();
+    anchors.push_back(0);
+    while (anchors.back() < last) {
+        next = rd.findNextAnchor(anchors.back(), flat);
+        if (next <= anchors.back())
+            next = last;
+        anchors.push_back(next);
+    }
+}
+
+// Split the road at the anchors, optimize each segment on its own with the
+// engine on the pool, then stitch them back together. The trajectory at the
+// anchors doesn't change, and the segments are blended into it over blend points.
+void optimizeSegments(Road &rd, SegmentEngine engine, ThreadPool &pool,
+                      int blend, bool redraw)
+{
+    TRACE_SCOPE("optimizeSegments");
+    if (rd.points.size() < 3)
+        return;
+    vector<int> anchors;
+    findAnchors(rd, anchors);
+    // the trajectory points are needed by the engines
+    rd.computeTrajPts(0, rd.points.size());
+    TaskGroup group(pool);
+    for (unsigned int i = 0; i < anchors.size() - 1; i++) {
+        int start = anchors[i], end = anchors[i + 1];
+        if (end - start < 2)
+            continue;
+        // Each task reads its own range of the road and only writes the points
+        // strictly between the two anchors, so the tasks don't overlap.
+        group.run([&rd, &engine, start, end, blend]() {
+            TRACE_SCOPE("segment");
+            Road seg;
+            rd.extractSegment(start, end, seg);
+            engine(seg);
+            rd.stitchSegment(seg, start, blend);
+        });
+    }
+    group.wait();
+    rd.computeTrajPts(0, rd.points.size());
+    if (redraw)
+        rd.drawTrajFromPoints();
+}
@@ -0,0 +1,45 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    segments.h
+   Updated: October 2026
+
+   Optimization of the trajectory on segments of the road between
+   anchors, running in parallel.
+
+**********************************************************************/
+
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include <vector>
+#include <functional>
+using namespace std;
+#include "road.h"
+#include "threadPool.h"
+
+// An engine optimizing the trajectory of a road segment in place. It
+// must not draw anything, since it doesn't run on the GLUT thread.
+typedef function<void(Road &)> SegmentEngine;
+
+// Some engines ready to be used: passes of optimizeTraj, passes of
+// smoothTrajectory, the minimum curvature solver and the grid DP. A GA
+// or any other optimizer can be plugged in as a function of a Road.
+SegmentEngine optimizeEngine(int passes);
+SegmentEngine smoothEngine(int radius, int passes = 1);
+SegmentEngine minCurvEngine();
+SegmentEngine gridEngine(int lanes, int stride = 1);
+
+// Find the anchors splitting the road, starting with 0 and ending with the
+// last point, with the centers of the flat stretches found by findNextAnchor
+// in between.
+void findAnchors(Road &rd, vector<int> &anchors);
+
+// Split the road at the anchors, optimize each segment on its own with the
+// engine on the pool, then stitch them back together. The trajectory at the
+// anchors doesn't change, and the segments are blended into it over blend points.
+void optimizeSegments(Road &rd, SegmentEngine engine, ThreadPool &pool,
+                      int blend = 10, bool redraw = true);
+
+#endif
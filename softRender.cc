@@ -0,0 +1,325 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    softRender.cc
+   Updated: October 2026
+
+   Definition of a class drawing the road and the trajectory in a
+   picture in memory, without OpenGL, so that the images can be made
+   on a machine without a display.
+
+**********************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include "softRender.h"
+#include "view.h"
+#include "threadPool.h"
+#include "pngWriter.h"
+#include "trace.h"
+#include "log.h"
+
+#define SUB_SAMPLES 4 // triangles are sampled on a grid of 4 x 4 points in each pixel
+
+// Constructor with the size of the picture.
+SoftRender::SoftRender(int w, int h)
+    : viewMin(0, 0, 0), viewMax(w, h, 0)
+{
+    width = w;
+    height = h;
+    clear();
+}
+
+// Set the view around the road like myinit does for the window. The picture
+// is shrunk to the proportions of the view, as the window is.
+void SoftRender::fitView(const Road &rd)
+{
+    viewMin = rd.min;
+    viewMax = rd.max;
+    setView(viewMin, viewMax, 0); // set x
+    setView(viewMin, viewMax, 1); // set y
+    fitWindow(viewMax.x() - viewMin.x(), viewMax.y() - viewMin.y(), width, height);
+    clear();
+}
+
+// Fill the picture with a color.
+void SoftRender::clear(GLfloat red, GLfloat green, GLfloat blue)
+{
+    pixels.resize(4 * width * height);
+    for (int i = 0; i < width * height; i++) {
+        pixels[4 * i] = 255 * red;
+        pixels[4 * i + 1] = 255 * green;
+        pixels[4 * i + 2] = 255 * blue;
+        pixels[4 * i + 3] = 255;
+    }
+}
+
+// Add a line or a triangle made of the vertices a, b, and c of the buffer.
+void SoftRender::addPrimitive(VertexBuffer &buf, int a, int b, int c, bool line)
+{
+    Primitive prim;
+    int index[3] = {a, b, c}, nrVert = line ? 2 : 3;
+    float scaleX = width / (viewMax.x() - viewMin.x()),
+          scaleY = height / (viewMax.y() - viewMin.y());
+    for (int i = 0; i < nrVert; i++) {
+        GLfloat *vertex = &buf.data[index[i] * VB_STRIDE];
+        prim.x[i] = (vertex[0] - viewMin.x()) * scaleX;
+        prim.y[i] = (viewMax.y() - vertex[1]) * scaleY; // the first row is at the top
+        for (int j = 0; j < 3; j++)
+            prim.color[i][j] = vertex[2 + j];
+    }
+    if (!line) {
+        // keep the vertices in the same order so that the edge functions are positive inside
+        float area = (prim.x[1] - prim.x[0]) * (prim.y[2] - prim.y[0]) -
+                     (prim.y[1] - prim.y[0]) * (prim.x[2] - prim.x[0]);
+        if (fabs(area) < 1e-9)
+            return;
+        if (area < 0) {
+            swap(prim.x[1], prim.x[2]);
+            swap(prim.y[1], prim.y[2]);
+            for (int j = 0; j < 3; j++)
+                swap(prim.color[1][j], prim.color[2][j]);
+        }
+    }
+    prims.push_back(prim);
+}
+
+// Add the primitive to the bins of all the tiles its box touches.
+void SoftRender::binPrimitive(int index, bool line, float margin)
+{
+    Primitive &prim = prims[index];
+    int nrVert = line ? 2 : 3;
+    float xMin = prim.x[0], xMax = prim.x[0], yMin = prim.y[0], yMax = prim.y[0];
+    for (int i = 1; i < nrVert; i++) {
+        xMin = min(xMin, prim.x[i]);
+        xMax = max(xMax, prim.x[i]);
+        yMin = min(yMin, prim.y[i]);
+        yMax = max(yMax, prim.y[i]);
+    }
+    int tx0 = floor((xMin - margin - 1) / TILE_SIZE), tx1 = floor((xMax + margin + 1) / TILE_SIZE),
+        ty0 = floor((yMin - margin - 1) / TILE_SIZE), ty1 = floor((yMax + margin + 1) / TILE_SIZE);
+    if (tx1 < 0 || ty1 < 0 || tx0 >= tilesX || ty0 >= tilesY)
+        return;
+    tx0 = max(tx0, 0);
+    ty0 = max(ty0, 0);
+    tx1 = min(tx1, tilesX - 1);
+    ty1 = min(ty1, tilesY - 1);
+    for (int ty = ty0; ty <= ty1; ty++)
+        for (int tx = tx0; tx <= tx1; tx++)
+            bins[ty * tilesX + tx].push_back(index);
+}
+
+// Draw the vertices of a buffer as given by its mode, with anti-aliased
+// edges. Lines have the given width in pixels.
+void SoftRender::draw(VertexBuffer &buf, float lineWidth)
+{
+    TRACE_SCOPE("SoftRender::draw");
+    int n = buf.size(), i;
+    bool lines = true;
+    prims.clear();
+    switch (buf.mode) {
+    case GL_LINES:
+        for (i = 0; i + 1 < n; i += 2)
+            addPrimitive(buf, i, i + 1, 0, true);
+        break;
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP:
+        for (i = 0; i + 1 < n; i++)
+            addPrimitive(buf, i, i + 1, 0, true);
+        if (buf.mode == GL_LINE_LOOP && n > 2)
+            addPrimitive(buf, n - 1, 0, 0, true);
+        break;
+    case GL_TRIANGLES:
+        lines = false;
+        for (i = 0; i + 2 < n; i += 3)
+            addPrimitive(buf, i, i + 1, i + 2, false);
+        break;
+    case GL_TRIANGLE_STRIP:
+        lines = false;
+        for (i = 0; i + 2 < n; i++)
+            addPrimitive(buf, i, i + 1, i + 2, false);
+        break;
+    default:
+        LOG(logError, "Cannot draw the primitive " << buf.mode << " without OpenGL");
+        return;
+    }
+
+    // sort the primitives by tile, keeping the order in which they are drawn
+    float halfWidth = 0.5 * lineWidth;
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    bins.assign(tilesX * tilesY, vector<int>());
+    for (i = 0; i < prims.size(); i++)
+        binPrimitive(i, lines, lines ? halfWidth : 0);
+
+    // the tiles don't share any pixel, so they can be drawn at the same time
+    TaskGroup group;
+    for (int ty = 0; ty < tilesY; ty++)
+        for (int tx = 0; tx < tilesX; tx++)
+            if (bins[ty * tilesX + tx].size())
+                group.run([this, tx, ty, lines, halfWidth]() {
+                    drawTile(tx, ty, lines, halfWidth);
+                });
+    group.wait();
+}
+
+// Draw the primitives in the bin of a tile and blend them in the picture.
+// Lines keep the largest coverage of a pixel, so the joints of a strip are not
+// darker, while the coverage of the triangles adds up, so that the shared
+// edges of a strip don't show.
+void SoftRender::drawTile(int tx, int ty, bool lines, float halfWidth)
+{
+    int x0 = tx * TILE_SIZE, y0 = ty * TILE_SIZE,
+        x1 = min(x0 + TILE_SIZE, width), y1 = min(y0 + TILE_SIZE, height);
+    vector<float> cover(TILE_SIZE * TILE_SIZE, 0), color(3 * TILE_SIZE * TILE_SIZE, 0);
+    vector<int> &bin = bins[ty * tilesX + tx];
+    int px, py, k, j, count, sx, sy;
+    float cx, cy, t, c, weight[3];
+
+    for (unsigned int b = 0; b < bin.size(); b++) {
+        Primitive &p = prims[bin[b]];
+        if (lines) {
+            float dx = p.x[1] - p.x[0], dy = p.y[1] - p.y[0], len2 = dx * dx + dy * dy,
+                  reach = halfWidth + 1;
+            int xs = max(x0, int(floor(min(p.x[0], p.x[1]) - reach))),
+                xe = min(x1, int(ceil(max(p.x[0], p.x[1]) + reach))),
+                ys = max(y0, int(floor(min(p.y[0], p.y[1]) - reach))),
+                ye = min(y1, int(ceil(max(p.y[0], p.y[1]) + reach)));
+            for (py = ys; py < ye; py++)
+                for (px = xs; px < xe; px++) {
+                    // coverage from the distance of the pixel center to the segment
+                    cx = px + 0.5 - p.x[0];
+                    cy = py + 0.5 - p.y[0];
+                    t = len2 > 0 ? (cx * dx + cy * dy) / len2 : 0;
+                    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+                    cx -= t * dx;
+                    cy -= t * dy;
+                    c = halfWidth + 0.5 - sqrt(cx * cx + cy * cy);
+                    if (c <= 0)
+                        continue;
+                    if (c > 1)
+                        c = 1;
+                    k = (py - y0) * TILE_SIZE + px - x0;
+                    if (c > cover[k]) {
+                        cover[k] = c;
+                        for (j = 0; j < 3; j++)
+                            color[3 * k + j] = (1 - t) * p.color[0][j] + t * p.color[1][j];
+                    }
+                }
+        }
+        else {
+            // edge i goes from the vertex i to the next one; the edge functions
+            // are positive inside, and the top-left rule decides the ties
+            float ex[3], ey[3], edge[3], reach[3], area;
+            bool topLeft[3], inside;
+            for (j = 0; j < 3; j++) {
+                ex[j] = p.x[(j + 1) % 3] - p.x[j];
+                ey[j] = p.y[(j + 1) % 3] - p.y[j];
+                topLeft[j] = (ey[j] == 0 && ex[j] < 0) || ey[j] > 0;
+            }
+            area = ex[0] * (p.y[2] - p.y[0]) - ey[0] * (p.x[2] - p.x[0]);
+            int xs = max(x0, int(floor(min(min(p.x[0], p.x[1]), p.x[2])))),
+                xe = min(x1, int(ceil(max(max(p.x[0], p.x[1]), p.x[2])))),
+                ys = max(y0, int(floor(min(min(p.y[0], p.y[1]), p.y[2])))),
+                ye = min(y1, int(ceil(max(max(p.y[0], p.y[1]), p.y[2]))));
+            for (j = 0; j < 3; j++)
+                reach[j] = 0.5 * (fabs(ex[j]) + fabs(ey[j])); // largest change inside a pixel
+            for (py = ys; py < ye; py++)
+                for (px = xs; px < xe; px++) {
+                    // edge functions at the pixel center decide if it's all in or all out
+                    cx = px + 0.5;
+                    cy = py + 0.5;
+                    inside = true;
+                    for (j = 0; j < 3; j++) {
+                        edge[j] = ex[j] * (cy - p.y[j]) - ey[j] * (cx - p.x[j]);
+                        if (edge[j] < -reach[j])
+                            break;
+                        if (edge[j] <= reach[j])
+                            inside = false;
+                    }
+                    if (j < 3)
+                        continue;
+                    if (inside)
+                        count = SUB_SAMPLES * SUB_SAMPLES;
+                    else {
+                        count = 0;
+                        for (sy = 0; sy < SUB_SAMPLES; sy++)
+                            for (sx = 0; sx < SUB_SAMPLES; sx++) {
+                                float ox = (sx + 0.5) / SUB_SAMPLES - 0.5,
+                                      oy = (sy + 0.5) / SUB_SAMPLES - 0.5;
+                                for (j = 0; j < 3; j++) {
+                                    float e = edge[j] + ex[j] * oy - ey[j] * ox;
+                                    if (e < 0 || (e == 0 && !topLeft[j]))
+                                        break;
+                                }
+                                if (j == 3)
+                                    count++;
+                            }
+                        if (!count)
+                            continue;
+                    }
+                    c = float(count) / (SUB_SAMPLES * SUB_SAMPLES);
+                    // the weight of a vertex comes from the edge facing it
+                    float sum = 0;
+                    for (j = 0; j < 3; j++) {
+                        weight[(j + 2) % 3] = edge[j] > 0 ? edge[j] / area : 0;
+                        sum += weight[(j + 2) % 3];
+                    }
+                    if (sum <= 0)
+                        weight[0] = sum = 1;
+                    k = (py - y0) * TILE_SIZE + px - x0;
+                    cover[k] += c;
+                    for (j = 0; j < 3; j++)
+                        color[3 * k + j] += c * (weight[0] * p.color[0][j] + weight[1] * p.color[1][j] +
+                                                 weight[2] * p.color[2][j]) / sum;
+                }
+        }
+    }
+
+    // blend the layer over the picture
+    for (py = y0; py < y1; py++)
+        for (px = x0; px < x1; px++) {
+            k = (py - y0) * TILE_SIZE + px - x0;
+            if (cover[k] <= 0)
+                continue;
+            c = cover[k] > 1 ? 1 : cover[k];
+            unsigned char *pixel = &pixels[4 * (py * width + px)];
+            for (j = 0; j < 3; j++) {
+                float src = lines ? color[3 * k + j] : color[3 * k + j] / cover[k];
+                src = src < 0 ? 0 : (src > 1 ? 1 : src);
+                pixel[j] = (unsigned char)(pixel[j] + (255 * src - pixel[j]) * c + 0.5);
+            }
+        }
+}
+
+// Draw the road and the trajectory like Road::display does. The centerline
+// can also be drawn over the ribbon.
+void SoftRender::drawRoad(const Road &rd, bool centerline)
+{
+    VertexBuffer buf;
+    if (rd.points.empty())
+        return;
+    if (rd.hasWidth) {
+        rd.fillRibbonVertices(buf);
+        draw(buf);
+    }
+    if (!rd.hasWidth || centerline) {
+        rd.fillLineVertices(buf);
+        if (rd.hasWidth) // white on the yellow ribbon
+            for (int i = 0; i < buf.size(); i++)
+                buf.data[i * VB_STRIDE + 4] = 1;
+        draw(buf);
+    }
+    if (rd.hasTraj) {
+        rd.fillTrajVertices(buf);
+        draw(buf, 1.5);
+    }
+}
+
+// Write the picture in a PNG file. Returns false if it could not be written.
+bool SoftRender::write(const char *filename)
+{
+    TRACE_SCOPE("SoftRender::write");
+    return writePNG(filename, width, height, pixels);
+}
@@ -0,0 +1,70 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    softRender.h
+   Updated: October 2026
+
+   Definition of a class drawing the road and the trajectory in a
+   picture in memory, without OpenGL, so that the images can be made
+   on a machine without a display.
+
+**********************************************************************/
+
+#ifndef SOFT_RENDER_H
+#define SOFT_RENDER_H
+
+#include "road.h"
+#include "vertexBuffer.h"
+
+#define TILE_SIZE 64 // the picture is drawn in parallel in squares of this size
+
+class SoftRender {
+public:
+    int width, height;
+    vector<unsigned char> pixels; // red, green, blue, alpha, row by row from the top
+    Point3f viewMin, viewMax;     // the area of the plane shown in the picture
+
+    // Constructor with the size of the picture.
+    SoftRender(int w = 1200, int h = 900);
+
+    // Set the view around the road like myinit does for the window. The picture
+    // is shrunk to the proportions of the view, as the window is.
+    void fitView(const Road &rd);
+
+    // Fill the picture with a color.
+    void clear(GLfloat red = 0, GLfloat green = 0, GLfloat blue = 0);
+
+    // Draw the vertices of a buffer as given by its mode, with anti-aliased
+    // edges. Lines have the given width in pixels.
+    void draw(VertexBuffer &buf, float lineWidth = 1);
+
+    // Draw the road and the trajectory like Road::display does. The centerline
+    // can also be drawn over the ribbon.
+    void drawRoad(const Road &rd, bool centerline = false);
+
+    // Write the picture in a PNG file. Returns false if it could not be written.
+    bool write(const char *filename);
+
+private:
+    // A line or a triangle in pixel coordinates, with a color for each vertex.
+    struct Primitive {
+        float x[3], y[3];
+        float color[3][3];
+    };
+
+    vector<Primitive> prims;
+    vector<vector<int> > bins; // the primitives touching each tile
+    int tilesX, tilesY;
+
+    // Add a line or a triangle made of the vertices a, b, and c of the buffer.
+    void addPrimitive(VertexBuffer &buf, int a, int b, int c, bool line);
+
+    // Add the primitive to the bins of all the tiles its box touches.
+    void binPrimitive(int index, bool line, float margin);
+
+    // Draw the primitives in the bin of a tile and blend them in the picture.
+    void drawTile(int tx, int ty, bool lines, float halfWidth);
+};
+
+#endif
@@ -0,0 +1,253 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    sweep.cc
+   Updated: October 2026
+
+   A search of the scales and the step of a road file that make the
+   road close on itself, building the road for many settings at the
+   same time from the data read once.
+
+**********************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+#include <chrono>
+#include "sweep.h"
+#include "trace.h"
+#include "log.h"
+
+// The value i of the range.
+static float rangeValue(SweepRange &range, int i)
+{
+    if (range.count <= 1)
+        return range.low;
+    return range.low + (range.high - range.low) * i / (range.count - 1);
+}
+
+// A range with the same number of values around center, going one spacing of
+// the range on each side, and not below minimum.
+static SweepRange rangeAround(SweepRange &range, float center, float minimum)
+{
+    SweepRange around = range;
+    if (range.count > 1) {
+        float spacing = (range.high - range.low) / (range.count - 1);
+        around.low = max(minimum, center - spacing);
+        around.high = center + spacing;
+    }
+    return around;
+}
+
+// Is the result a better one?
+static bool betterResult(const SweepResult &a, const SweepResult &b)
+{
+    return a.score < b.score;
+}
+
+// Were the two results built with the same settings?
+static bool sameSettings(const SweepResult &a, const SweepResult &b)
+{
+    return a.roadScale == b.roadScale && a.leftScale == b.leftScale && a.roadStep == b.roadStep;
+}
+
+// Build the road from the data with the settings of base, except for the scales
+// and the step given in result, and store how far it is from closing in result.
+// The road rd is used for the points.
+void evalSweep(const CurvData &data, const Road &base, Road &rd, SweepResult &result)
+{
+    rd.copySettings(base);
+    rd.roadScale = result.roadScale;
+    rd.leftScale = result.leftScale;
+    rd.roadStep = result.roadStep;
+    if (rd.rdType == skipStep)
+        rd.buildStepPointList(data, 0, FLT_MAX);
+    else
+        rd.buildPointList(data, 0, FLT_MAX);
+    int n = rd.points.size();
+    if (n < 3) {
+        result.distError = result.headingError = result.length = 0;
+        result.score = FLT_MAX;
+        return;
+    }
+    Point3f &first = rd.points[0].pt, &second = rd.points[1].pt,
+            &beforeLast = rd.points[n - 2].pt, &last = rd.points[n - 1].pt;
+    float heading = atan2(last.y() - beforeLast.y(), last.x() - beforeLast.x()) -
+                    atan2(second.y() - first.y(), second.x() - first.x());
+    heading = remainder(heading, 2 * M_PI); // between -pi and pi
+    result.distError = first.distance(last);
+    result.headingError = fabs(heading);
+    result.length = rd.points[n - 1].dist - rd.points[0].dist;
+    if (result.length > 0)
+        result.score = result.distError / result.length + result.headingError / (2 * M_PI);
+    else
+        result.score = FLT_MAX;
+}
+
+// Build the road for all the combinations of the values of the three ranges on
+// the pool and return the results from the best to the worst. If base reads the
+// roads with skipStep, only the step changes, otherwise only the scales.
+vector<SweepResult> gridSweep(const CurvData &data, const Road &base, SweepRange scale,
+                              SweepRange left, SweepRange step, ThreadPool &pool)
+{
+    TRACE_SCOPE("gridSweep");
+    vector<SweepResult> results;
+    SweepResult result;
+    // skipStep doesn't scale the curvature, and allScale doesn't use the step
+    if (base.rdType == skipStep) {
+        scale.low = base.roadScale;
+        left.low = base.leftScale;
+        scale.count = left.count = 1;
+    }
+    else {
+        step.low = base.roadStep;
+        step.count = 1;
+    }
+    for (int i = 0; i < max(scale.count, 1); i++)
+        for (int j = 0; j < max(left.count, 1); j++)
+            for (int k = 0; k < max(step.count, 1); k++) {
+                result.roadScale = rangeValue(scale, i);
+                result.leftScale = rangeValue(left, j);
+                result.roadStep = rangeValue(step, k);
+                results.push_back(result);
+            }
+    // each range of settings is built in its own road, reusing the points
+    int grain = max(1, (int)results.size() / (4 * pool.size()));
+    parallel_for(0, results.size(), grain, [&data, &base, &results](int begin, int end) {
+        Road rd;
+        for (int i = begin; i < end; i++)
+            evalSweep(data, base, rd, results[i]);
+    }, pool);
+    stable_sort(results.begin(), results.end(), betterResult);
+    return results;
+}
+
+// Run the grid sweep, then levels times again on a grid around the best result
+// with ranges reduced to two spacings of the previous grid. Returns all the
+// results from the best to the worst.
+vector<SweepResult> refineSweep(const CurvData &data, const Road &base, SweepRange scale,
+                                SweepRange left, SweepRange step, int levels,
+                                ThreadPool &pool)
+{
+    vector<SweepResult> all = gridSweep(data, base, scale, left, step, pool), finer;
+    for (int l = 0; l < levels && all.size(); l++) {
+        scale = rangeAround(scale, all[0].roadScale, 0);
+        left = rangeAround(left, all[0].leftScale, 0);
+        step = rangeAround(step, all[0].roadStep, 1);
+        finer = gridSweep(data, base, scale, left, step, pool);
+        all.insert(all.end(), finer.begin(), finer.end());
+        stable_sort(all.begin(), all.end(), betterResult);
+        // the center of the finer grid was already in the previous one
+        all.erase(unique(all.begin(), all.end(), sameSettings), all.end());
+    }
+    return all;
+}
+
+// Read a range written as low:high:count, or a single value.
+static bool parseRange(const char *text, SweepRange &range)
+{
+    int read = sscanf(text, "%f:%f:%d", &range.low, &range.high, &range.count);
+    if (read == 1) {
+        range.high = range.low;
+        range.count = 1;
+        return true;
+    }
+    return read == 3 && range.count >= 1 && range.low <= range.high;
+}
+
+// Output the options of the sweep.
+static void sweepUsage()
+{
+    cout << "Usage: roadviz sweep [options] track" << endl
+         << "  -scale l:h:n   values of the road scale (default 0.05:0.3:11)" << endl
+         << "  -left l:h:n    values of the left scale (default 0.2:1:9)" << endl
+         << "  -step l:h:n    values of the road step, read with skipStep, which doesn't" << endl
+         << "                 use the scales (default none)" << endl
+         << "  -refine n      sweeps on finer grids around the best result (default 0)" << endl
+         << "  -threads n     number of roads built at the same time" << endl
+         << "  -top n         number of results output (default 10)" << endl
+         << "The roads are scored by the distance and the heading between their ends." << endl;
+}
+
+// Main function of the sweep, called with the arguments after "sweep".
+int sweepMain(int argc, char **argv)
+{
+    SweepRange scale = {0.05, 0.3, 11}, left = {0.2, 1, 9}, step = {3.8, 3.8, 1};
+    int levels = 0, nrThreads = 0, top = 10;
+    const char *track = NULL;
+    Road base;
+    for (int i = 0; i < argc; i++) {
+        if (argv[i][0] != '-' && !track)
+            track = argv[i];
+        else if (i + 1 >= argc) {
+            sweepUsage();
+            return 2;
+        }
+        else if (!strcmp(argv[i], "-scale") && parseRange(argv[i + 1], scale))
+            i++;
+        else if (!strcmp(argv[i], "-left") && parseRange(argv[i + 1], left))
+            i++;
+        else if (!strcmp(argv[i], "-step") && parseRange(argv[i + 1], step)) {
+            base.rdType = skipStep;
+            i++;
+        }
+        else if (!strcmp(argv[i], "-refine"))
+            levels = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-threads"))
+            nrThreads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-top"))
+            top = atoi(argv[++i]);
+        else {
+            sweepUsage();
+            return 2;
+        }
+    }
+    if (!track) {
+        sweepUsage();
+        return 2;
+    }
+
+    CurvData data;
+    ifstream fin(track);
+    if (!fin.good()) {
+        cout << "Could not open the road file " << track << endl;
+        return 1;
+    }
+    readCurvData(fin, data);
+    fin.close();
+    if (data.dist.size() < 3) {
+        cout << "Not enough points in " << track << endl;
+        return 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ThreadPool pool(nrThreads);
+    vector<SweepResult> results = refineSweep(data, base, scale, left, step, levels, pool);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    logFlush(); // the messages of the sweep come before the table
+    cout << results.size() << " roads of " << data.dist.size() << " points built in "
+         << seconds << " seconds" << endl;
+    cout << "Road scale\tLeft scale\tStep\tDistance\tHeading\tScore" << endl;
+    cout << fixed;
+    for (int i = 0; i < results.size() && i < top; i++) {
+        SweepResult &r = results[i];
+        cout << setprecision(4) << r.roadScale << "\t\t" << r.leftScale << "\t\t"
+             << setprecision(2) << r.roadStep << "\t" << r.distError << "\t\t"
+             << r.headingError * 180 / M_PI << "\t" << setprecision(5) << r.score << endl;
+    }
+    if (results.size() && results[0].score < FLT_MAX) {
+        cout << setprecision(4) << "Best: road scale " << results[0].roadScale
+             << ", left scale " << results[0].leftScale;
+        if (base.rdType == skipStep)
+            cout << ", step " << results[0].roadStep;
+        cout << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    sweep.h
+   Updated: October 2026
+
+   A search of the scales and the step of a road file that make the
+   road close on itself, building the road for many settings at the
+   same time from the data read once.
+
+**********************************************************************/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <vector>
+using namespace std;
+#include "road.h"
+#include "threadPool.h"
+
+// The values tried for one setting: count values evenly spaced from low to high.
+struct SweepRange {
+    float low, high;
+    int count;
+};
+
+// The settings the road was built with and how far it is from closing.
+struct SweepResult {
+    float roadScale, leftScale, roadStep;
+    float distError;    // distance between the first and the last point
+    float headingError; // angle between the first and the last segment, in radians
+    float length;       // length of the road
+    float score;        // distError / length + headingError / (2 pi), lower is better
+};
+
+// Build the road from the data with the settings of base, except for the scales
+// and the step given in result, and store how far it is from closing in result.
+// The road rd is used for the points.
+void evalSweep(const CurvData &data, const Road &base, Road &rd, SweepResult &result);
+
+// Build the road for all the combinations of the values of the three ranges on
+// the pool and return the results from the best to the worst. If base reads the
+// roads with skipStep, only the step changes, otherwise only the scales.
+vector<SweepResult> gridSweep(const CurvData &data, const Road &base, SweepRange scale,
+                              SweepRange left, SweepRange step, ThreadPool &pool);
+
+// Run the grid sweep, then levels times again on a grid around the best result
+// with ranges reduced to two spacings of the previous grid. Returns all the
+// results from the best to the worst.
+vector<SweepResult> refineSweep(const CurvData &data, const Road &base, SweepRange scale,
+                                SweepRange left, SweepRange step, int levels,
+                                ThreadPool &pool);
+
+// Main function of the sweep, called with the arguments after "sweep".
+int sweepMain(int argc, char **argv);
+
+#endif
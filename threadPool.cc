@@ -0,0 +1,222 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    threadPool.cc
+   Updated: October 2026
+
+   Implementation of a pool of threads running the tasks submitted to
+   it, each thread with its own queue and stealing from the others
+   when it's empty, and of parallel loops over ranges of indexes.
+
+**********************************************************************/
+
+#include <cstdlib>
+#include <chrono>
+#include "threadPool.h"
+#include "trace.h"
+
+// The pool the current thread belongs to, and its index in that pool.
+static thread_local ThreadPool *currentPool = NULL;
+static thread_local int currentSelf = -1;
+
+// Constructor with the pool that runs the tasks.
+TaskGroup::TaskGroup(ThreadPool &pool)
+    : pool(pool)
+{
+    pending = 0;
+}
+
+// Destructor: waits for the tasks that are left.
+TaskGroup::~TaskGroup()
+{
+    wait();
+}
+
+// Add a task to the group. It will run on one of the threads.
+void TaskGroup::run(function<void()> task)
+{
+    pending++;
+    pool.submit(this, task);
+}
+
+// Wait until all the tasks of the group are done.
+void TaskGroup::wait()
+{
+    while (pending > 0) {
+        // help with the tasks of the pool, which may be ours
+        if (pool.runOne())
+            continue;
+        // the tasks left are running on other threads, or will start new ones
+        unique_lock<mutex> guard(lock);
+        if (pending > 0)
+            done.wait_for(guard, chrono::milliseconds(1));
+    }
+    // finished() holds the lock until it is done with the group
+    unique_lock<mutex> guard(lock);
+}
+
+// Called by the pool when one of the tasks is finished.
+void TaskGroup::finished()
+{
+    unique_lock<mutex> guard(lock);
+    if (--pending == 0)
+        done.notify_all();
+}
+
+// Constructor with the number of threads; 0 means the value of the
+// environment variable ROADVIZ_THREADS, or one per hardware thread.
+ThreadPool::ThreadPool(int nrThreads)
+{
+    queued = 0;
+    next = 0;
+    stopping = false;
+    if (nrThreads <= 0 && getenv("ROADVIZ_THREADS"))
+        nrThreads = atoi(getenv("ROADVIZ_THREADS"));
+    if (nrThreads <= 0)
+        nrThreads = thread::hardware_concurrency();
+    if (nrThreads <= 0)
+        nrThreads = 1;
+    for (int i = 0; i < nrThreads; i++)
+        queues.push_back(new WorkQueue);
+    for (int i = 0; i < nrThreads; i++)
+        workers.push_back(thread(&ThreadPool::work, this, i));
+}
+
+// Destructor: finishes the tasks in the queues, then stops the threads.
+ThreadPool::~ThreadPool()
+{
+    {
+        unique_lock<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    hasWork.notify_all();
+    for (unsigned int i = 0; i < workers.size(); i++)
+        workers[i].join();
+    for (unsigned int i = 0; i < queues.size(); i++)
+        delete queues[i];
+}
+
+// The number of threads in the pool.
+int ThreadPool::size()
+{
+    return workers.size();
+}
+
+// The index of the current thread in the pool, or -1.
+int ThreadPool::currentIndex()
+{
+    return currentPool == this ? currentSelf : -1;
+}
+
+// Add a task of the group to the queue of the current thread if it belongs
+// to the pool, or to the queues in turn otherwise.
+void ThreadPool::submit(TaskGroup *group, function<void()> task)
+{
+    int self = currentIndex();
+    WorkQueue &queue = *queues[self >= 0 ? self : next++ % queues.size()];
+    {
+        unique_lock<mutex> guard(queue.lock);
+        Task t = {task, group};
+        queue.tasks.push_back(t);
+    }
+    TRACE_COUNT("queued tasks", ++queued);
+    {
+        // a thread going to sleep either sees the task or gets the notification
+        unique_lock<mutex> guard(sleepLock);
+    }
+    hasWork.notify_one();
+}
+
+// Take a task from the queue of the thread self, or steal one from another
+// queue. self is -1 for a thread outside of the pool.
+bool ThreadPool::take(int self, Task &task)
+{
+    int n = queues.size();
+    if (self >= 0) {
+        // the last task added is the one most likely to have its data in the cache
+        unique_lock<mutex> guard(queues[self]->lock);
+        if (queues[self]->tasks.size()) {
+            task = queues[self]->tasks.back();
+            queues[self]->tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    // the oldest task of another queue is the one most likely to be split further
+    for (int k = 1; k <= n; k++) {
+        int q = (max(self, 0) + k) % n;
+        if (q == self)
+            continue;
+        WorkQueue &other = *queues[q];
+        unique_lock<mutex> guard(other.lock);
+        if (other.tasks.size()) {
+            task = other.tasks.front();
+            other.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run one task if there is any. Returns false if there was none.
+bool ThreadPool::runOne()
+{
+    Task task;
+    if (!take(currentIndex(), task))
+        return false;
+    {
+        TRACE_SCOPE("ThreadPool task");
+        task.work();
+    }
+    task.group->finished();
+    return true;
+}
+
+// Main loop of each thread.
+void ThreadPool::work(int self)
+{
+    currentPool = this;
+    currentSelf = self;
+    while (true) {
+        if (runOne())
+            continue;
+        unique_lock<mutex> guard(sleepLock);
+        while (queued <= 0 && !stopping)
+            hasWork.wait(guard);
+        if (queued <= 0)
+            return; // stopping and nothing left to do
+    }
+}
+
+// The pool shared by the whole application, created on the first call.
+ThreadPool &sharedPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+// Call body(begin, end) on consecutive ranges of at most grain indexes covering
+// first to last, not included, on the threads of the pool and on the calling
+// one. A range of a single grain is done right away on the calling thread.
+void parallel_for(int first, int last, int grain, function<void(int, int)> body,
+                  ThreadPool &pool)
+{
+    if (last <= first)
+        return;
+    if (grain < 1)
+        grain = 1;
+    if (last - first <= grain) {
+        body(first, last);
+        return;
+    }
+    TaskGroup group(pool);
+    for (int start = first + grain; start < last; start += grain) {
+        int end = min(start + grain, last);
+        group.run([&body, start, end]() { body(start, end); });
+    }
+    // the calling thread does the first range while the others start
+    body(first, first + grain);
+    group.wait();
+}
@@ -0,0 +1,147 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    threadPool.h
+   Updated: October 2026
+
+   Definition of a pool of threads running the tasks submitted to it,
+   each thread with its own queue and stealing from the others when
+   it's empty, and of parallel loops over ranges of indexes.
+
+**********************************************************************/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+using namespace std;
+
+class ThreadPool;
+
+// The pool shared by the whole application, created on the first call.
+ThreadPool &sharedPool();
+
+// A set of tasks that can be waited for together. Waiting runs tasks of the
+// pool, so a task can start other tasks and wait for them without blocking a
+// thread of the pool.
+class TaskGroup {
+public:
+    // Constructor with the pool that runs the tasks.
+    TaskGroup(ThreadPool &pool = sharedPool());
+
+    // Destructor: waits for the tasks that are left.
+    ~TaskGroup();
+
+    // Add a task to the group. It will run on one of the threads.
+    void run(function<void()> task);
+
+    // Wait until all the tasks of the group are done.
+    void wait();
+
+private:
+    friend class ThreadPool;
+    ThreadPool &pool;
+    atomic<int> pending; // tasks added and not finished yet
+    mutex lock;
+    condition_variable done;
+
+    // Called by the pool when one of the tasks is finished.
+    void finished();
+};
+
+class ThreadPool {
+public:
+    // Constructor with the number of threads; 0 means the value of the
+    // environment variable ROADVIZ_THREADS, or one per hardware thread.
+    ThreadPool(int nrThreads = 0);
+
+    // Destructor: finishes the tasks in the queues, then stops the threads.
+    ~ThreadPool();
+
+    // The number of threads in the pool.
+    int size();
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        function<void()> work;
+        TaskGroup *group;
+    };
+
+    // The tasks of one thread: it takes the last one, the others steal the first one.
+    struct WorkQueue {
+        mutex lock;
+        deque<Task> tasks;
+    };
+
+    vector<thread> workers;
+    vector<WorkQueue *> queues;
+    atomic<int> queued;        // tasks in all the queues
+    atomic<unsigned int> next; // queue of the next task submitted from outside the pool
+    mutex sleepLock;
+    condition_variable hasWork;
+    bool stopping;
+
+    // Add a task of the group to the queue of the current thread if it belongs
+    // to the pool, or to the queues in turn otherwise.
+    void submit(TaskGroup *group, function<void()> task);
+
+    // Take a task from the queue of the thread self, or steal one from another
+    // queue. self is -1 for a thread outside of the pool.
+    bool take(int self, Task &task);
+
+    // Run one task if there is any. Returns false if there was none.
+    bool runOne();
+
+    // The index of the current thread in the pool, or -1.
+    int currentIndex();
+
+    // Main loop of each thread.
+    void work(int self);
+};
+
+// Call body(begin, end) on consecutive ranges of at most grain indexes covering
+// first to last, not included, on the threads of the pool and on the calling
+// one. A range of a single grain is done right away on the calling thread.
+void parallel_for(int first, int last, int grain, function<void(int, int)> body,
+                  ThreadPool &pool = sharedPool());
+
+// Compute body(begin, end), returning a T, on the ranges of parallel_for and
+// combine the results with combine(T, T) two by two in a fixed order, starting
+// from the first ones, so that the result doesn't depend on the number of
+// threads, only on grain. Returns init if the range is empty.
+template <class T, class Body, class Combine>
+T parallel_reduce(int first, int last, int grain, T init, Body body, Combine combine,
+                  ThreadPool &pool = sharedPool())
+{
+    if (last <= first)
+        return init;
+    if (grain < 1)
+        grain = 1;
+    int nrRanges = (last - first + grain - 1) / grain;
+    if (nrRanges == 1)
+        return combine(init, body(first, last));
+    vector<T> partial(nrRanges);
+    parallel_for(0, nrRanges, 1, [&](int begin, int end) {
+        for (int r = begin; r < end; r++) {
+            int start = first + r * grain;
+            partial[r] = body(start, min(start + grain, last));
+        }
+    }, pool);
+    // combine the neighbors, then the neighbors of the results, and so on
+    for (int step = 1; step < nrRanges; step *= 2)
+        for (int r = 0; r + step < nrRanges; r += 2 * step)
+            partial[r] = combine(partial[r], partial[r + step]);
+    return combine(init, partial[0]);
+}
+
+#endif
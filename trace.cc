@@ -0,0 +1,204 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trace.cc
+   Updated: October 2026
+
+   Scoped timers and counters on the road pipeline, written as a
+   Chrome trace that Perfetto or chrome://tracing can open, with a
+   summary of the time spent in each part at the end of the run.
+
+**********************************************************************/
+
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include "trace.h"
+
+#define TRACE_MAX_EVENTS 1000000 // events kept per thread; the summary counts all of them
+
+// A span of time, or the value of a counter if length is negative.
+struct TraceEvent {
+    const char *name;
+    double start, length;
+};
+
+// Calls and times of the spans with the same name.
+struct TraceStat {
+    long calls;
+    double total, longest;
+};
+
+// The events of one thread. Only that thread adds to them, but they are read
+// when the trace is written, so they have a lock that is almost never contended.
+struct TraceThread {
+    int tid;
+    mutex lock;
+    vector<TraceEvent> events;
+    unordered_map<const char *, TraceStat> stats;
+};
+
+atomic<bool> traceOn(false);
+
+static chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+static mutex threadsLock;
+static vector<TraceThread *> threads; // never deleted, the events outlive the threads
+static string traceFile;
+
+// The events of the current thread, created on its first event.
+static TraceThread &currentThread()
+{
+    thread_local TraceThread *mine = NULL;
+    if (!mine) {
+        mine = new TraceThread;
+        unique_lock<mutex> guard(threadsLock);
+        mine->tid = threads.size();
+        threads.push_back(mine);
+    }
+    return *mine;
+}
+
+// Called when the program exits: write the trace and output the summary.
+static void traceAtExit()
+{
+    traceOn = false;
+    if (traceWrite(traceFile.c_str()))
+        cout << "Trace written in " << traceFile << endl;
+    else
+        cout << "Could not write the trace in " << traceFile << endl;
+    traceSummary(cout);
+}
+
+// Start recording the events. They are written in the file and the summary is
+// output when the program exits.
+void traceStart(const char *filename)
+{
+    if (traceFile.empty())
+        atexit(traceAtExit);
+    traceFile = filename;
+    currentThread(); // the thread starting the trace is the main one
+    traceOn = true;
+}
+
+// Start recording if the environment variable ROADVIZ_TRACE gives a file name.
+void traceFromEnv()
+{
+    const char *filename = getenv("ROADVIZ_TRACE");
+    if (filename && filename[0])
+        traceStart(filename);
+}
+
+// Microseconds since the trace started.
+double traceNow()
+{
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - origin).count();
+}
+
+// Record the span named name on the current thread, from start to now. The
+// name must be a string literal, or live until the end of the program.
+void traceSpan(const char *name, double start)
+{
+    double length = traceNow() - start;
+    TraceThread &mine = currentThread();
+    unique_lock<mutex> guard(mine.lock);
+    if (mine.events.size() < TRACE_MAX_EVENTS) {
+        TraceEvent event = {name, start, length};
+        mine.events.push_back(event);
+    }
+    TraceStat &stat = mine.stats[name];
+    stat.calls++;
+    stat.total += length;
+    stat.longest = max(stat.longest, length);
+}
+
+// Record the value of the counter named name.
+void traceCount(const char *name, double value)
+{
+    TraceThread &mine = currentThread();
+    unique_lock<mutex> guard(mine.lock);
+    if (mine.events.size() < TRACE_MAX_EVENTS) {
+        // the value is stored in start, the time in length
+        TraceEvent event = {name, value, -1 - traceNow()};
+        mine.events.push_back(event);
+    }
+}
+
+// Write the events recorded so far in the file in the Chrome trace format.
+// Returns false if the file cannot be written.
+bool traceWrite(const char *filename)
+{
+    ofstream fout(filename);
+    char line[200];
+    if (!fout.good())
+        return false;
+    fout << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+    fout << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, "
+         << "\"args\": {\"name\": \"roadviz\"}}";
+    unique_lock<mutex> guard(threadsLock);
+    for (int t = 0; t < threads.size(); t++) {
+        TraceThread &th = *threads[t];
+        unique_lock<mutex> threadGuard(th.lock);
+        if (th.tid == 0)
+            fout << "," << endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                 << "\"tid\": 0, \"args\": {\"name\": \"main\"}}";
+        else
+            fout << "," << endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                 << "\"tid\": " << th.tid << ", \"args\": {\"name\": \"thread " << th.tid << "\"}}";
+        for (int i = 0; i < th.events.size(); i++) {
+            TraceEvent &e = th.events[i];
+            if (e.length >= 0)
+                snprintf(line, sizeof(line), ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, "
+                         "\"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}", e.name, th.tid, e.start, e.length);
+            else
+                snprintf(line, sizeof(line), ",\n{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 1, "
+                         "\"tid\": %d, \"ts\": %.3f, \"args\": {\"value\": %g}}", e.name, th.tid,
+                         -1 - e.length, e.start);
+            fout << line;
+        }
+    }
+    fout << endl << "]}" << endl;
+    fout.close();
+    return !fout.fail();
+}
+
+// Output the number of calls, the total, average and longest time of each span.
+void traceSummary(ostream &out)
+{
+    // the same name may have several addresses, so they are merged as strings
+    map<string, TraceStat> all;
+    {
+        unique_lock<mutex> guard(threadsLock);
+        for (int t = 0; t < threads.size(); t++) {
+            unique_lock<mutex> threadGuard(threads[t]->lock);
+            for (auto it = threads[t]->stats.begin(); it != threads[t]->stats.end(); it++) {
+                TraceStat &stat = all[it->first];
+                stat.calls += it->second.calls;
+                stat.total += it->second.total;
+                stat.longest = max(stat.longest, it->second.longest);
+            }
+        }
+    }
+    vector<pair<string, TraceStat> > sorted(all.begin(), all.end());
+    sort(sorted.begin(), sorted.end(),
+         [](const pair<string, TraceStat> &a, const pair<string, TraceStat> &b) {
+             return a.second.total > b.second.total;
+         });
+    out << setw(32) << left << "Span" << right << setw(10) << "Calls" << setw(14) << "Total ms"
+        << setw(12) << "Mean ms" << setw(12) << "Max ms" << endl;
+    for (int i = 0; i < sorted.size(); i++) {
+        TraceStat &stat = sorted[i].second;
+        out << setw(32) << left << sorted[i].first << right << setw(10) << stat.calls << fixed
+            << setprecision(3) << setw(14) << stat.total / 1000
+            << setw(12) << stat.total / stat.calls / 1000 << setw(12) << stat.longest / 1000 << endl;
+    }
+    out.unsetf(ios::fixed);
+}
@@ -0,0 +1,82 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trace.h
+   Updated: October 2026
+
+   Scoped timers and counters on the road pipeline, written as a
+   Chrome trace that Perfetto or chrome://tracing can open, with a
+   summary of the time spent in each part at the end of the run.
+
+**********************************************************************/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+#include <atomic>
+using namespace std;
+
+// The events are recorded only while this is true. Compiling with -DNO_TRACE
+// removes the macros below entirely.
+extern atomic<bool> traceOn;
+
+// Start recording the events. They are written in the file and the summary is
+// output when the program exits.
+void traceStart(const char *filename);
+
+// Start recording if the environment variable ROADVIZ_TRACE gives a file name.
+void traceFromEnv();
+
+// Microseconds since the trace started.
+double traceNow();
+
+// Record the span named name on the current thread, from start to now. The
+// name must be a string literal, or live until the end of the program.
+void traceSpan(const char *name, double start);
+
+// Record the value of the counter named name.
+void traceCount(const char *name, double value);
+
+// Write the events recorded so far in the file in the Chrome trace format.
+// Returns false if the file cannot be written.
+bool traceWrite(const char *filename);
+
+// Output the number of calls, the total, average and longest time of each span.
+void traceSummary(ostream &out);
+
+// Records the time spent in the scope where it is declared. When the trace is
+// off, it costs only the test of the flag.
+class TraceScope {
+public:
+    TraceScope(const char *name)
+    {
+        this->name = name;
+        start = traceOn.load(memory_order_relaxed) ? traceNow() : -1;
+    }
+
+    ~TraceScope()
+    {
+        if (start >= 0)
+            traceSpan(name, start);
+    }
+
+private:
+    const char *name;
+    double start;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+
+#ifdef NO_TRACE
+#define TRACE_SCOPE(name)
+#define TRACE_COUNT(name, value)
+#else
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_COUNT(name, value) \
+    do { if (traceOn.load(memory_order_relaxed)) traceCount(name, value); } while (0)
+#endif
+
+#endif
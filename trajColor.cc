@@ -0,0 +1,111 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trajColor.cc
+   Updated: October 2026
+
+   Computation of the colors of the trajectory points for the various
+   coloring modes, in parallel.
+
+**********************************************************************/
+
+#include "trajColor.h"
+
+#define COLOR_GRAIN 8192 // number of points colored by one task
+
+// Name of a coloring mode, for the messages.
+const char *colorModeName(TrajColorMode mode)
+{
+    switch (mode) {
+    case curvAgreeColor:
+        return "curvature agreement";
+    case curvHeatColor:
+        return "curvature heat map";
+    case ctrlPtColor:
+        return "control points";
+    case keyFrameColor:
+        return "keyframes";
+    default:
+        return "unknown";
+    }
+}
+
+// Color the points from begin to end, not included. The control points
+// are marked in isCtrl, only needed in that mode.
+static void colorChunk(const Road &rd, TrajColorMode mode, const vector<unsigned char> &isCtrl,
+                       int first, int begin, int end, GLfloat *out, int stride)
+{
+    GLfloat red = 0, blue = 0, *color;
+    float realTC;
+    int i, kf = 1, low, high, mid, nrKF = rd.keyframes.size();
+    if (mode == keyFrameColor) {
+        // first keyframe at or after begin; the color switched at all the ones before
+        low = 1;
+        high = nrKF;
+        while (low < high) {
+            mid = (low + high) / 2;
+            if (rd.keyframes[mid].pt < begin)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        kf = low;
+        red = (kf - 1) % 2 ? 0 : 1;
+        blue = 1 - red;
+    }
+    for (i = begin; i < end; i++) {
+        switch (mode) {
+        case curvAgreeColor:
+            // red for real curvature and road curvature going in the same direction
+            realTC = rd.realTrajCurv(i);
+            red = rd.points[i].curv * realTC >= 0 ? 1 : 0;
+            blue = 1 - red;
+            break;
+        case curvHeatColor:
+            blue = 0.5 * (rd.points[i].curv + 1) / rd.maxCurv;
+            red = 0.5 * (rd.realTrajCurv(i) + 1) / rd.maxCurv;
+            break;
+        case ctrlPtColor:
+            blue = isCtrl[i] ? 1 : 0;
+            red = 1 - blue;
+            break;
+        case keyFrameColor:
+            // merge walk: switch every time we hit a keyframe
+            while (kf < nrKF && rd.keyframes[kf].pt <= i) {
+                kf++;
+                red = 1 - red;
+                blue = 1 - blue;
+            }
+            break;
+        default:
+            break;
+        }
+        color = out + (i - first) * stride;
+        color[0] = red;
+        color[1] = 0;
+        color[2] = blue;
+    }
+}
+
+// Compute the color of the trajectory points from first to last, not
+// included, for a given mode. The red, green, and blue of the point i are
+// stored at out[(i - first) * stride], so the colors can go directly in
+// an interleaved vertex array. Large ranges are split between the threads
+// of the pool. Only reads the road, so it can run for several roads or
+// ranges at the same time.
+void computeTrajColors(const Road &rd, TrajColorMode mode, int first, int last,
+                       GLfloat *out, int stride, ThreadPool &pool)
+{
+    vector<unsigned char> isCtrl;
+    if (mode == ctrlPtColor) {
+        // a bitmap instead of searching the list for every point
+        isCtrl.assign(rd.points.size(), 0);
+        for (unsigned int k = 0; k < rd.ctrlPts.size(); k++)
+            if (rd.ctrlPts[k] >= 0 && rd.ctrlPts[k] < rd.points.size())
+                isCtrl[rd.ctrlPts[k]] = 1;
+    }
+    parallel_for(first, last, COLOR_GRAIN, [&rd, mode, &isCtrl, first, out, stride](int begin, int end) {
+        colorChunk(rd, mode, isCtrl, first, begin, end, out, stride);
+    }, pool);
+}
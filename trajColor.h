@@ -0,0 +1,31 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trajColor.h
+   Updated: October 2026
+
+   Computation of the colors of the trajectory points for the various
+   coloring modes, in parallel.
+
+**********************************************************************/
+
+#ifndef TRAJ_COLOR_H
+#define TRAJ_COLOR_H
+
+#include "road.h"
+#include "threadPool.h"
+
+// Name of a coloring mode, for the messages.
+const char *colorModeName(TrajColorMode mode);
+
+// Compute the color of the trajectory points from first to last, not
+// included, for a given mode. The red, green, and blue of the point i are
+// stored at out[(i - first) * stride], so the colors can go directly in
+// an interleaved vertex array. Large ranges are split between the threads
+// of the pool. Only reads the road, so it can run for several roads or
+// ranges at the same time.
+void computeTrajColors(const Road &rd, TrajColorMode mode, int first, int last,
+                       GLfloat *out, int stride, ThreadPool &pool);
+
+#endif
@@ -0,0 +1,172 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trajDP.cc
+   Updated: October 2026
+
+   Definition of a class optimizing the trajectory by dynamic
+   programming over a grid of lateral positions.
+
+**********************************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include "trajDP.h"
+#include "threadPool.h"
+#include "trace.h"
+
+// Compute the best cost of the states (b, c) of a stage for all the lanes c,
+// going through the lane b of the middle stage, and the lane of the stage
+// before it that gives that cost. cost holds the costs of the states (a, b)
+// of the previous stage, p0 and p2 the candidates of the stages on each side,
+// and p1 is the lane b. The results are stored with a stride of k.
+// The loops have no branches and the arrays don't overlap, so that the
+// compiler can vectorize them. The costs are positive, so their bits compare
+// as integers in the same order as the floats, which lets the min and its
+// position be vectorized without changing the floating point semantics.
+static void stageLane(int k, const float *__restrict cost,
+                      const float *__restrict px0, const float *__restrict py0,
+                      float px1, float py1,
+                      const float *__restrict px2, const float *__restrict py2,
+                      float weight, float *__restrict newCost, unsigned char *__restrict bk)
+{
+    float ux[MAX_LANES], uy[MAX_LANES], uInv[MAX_LANES];
+    int32_t value[MAX_LANES]; // bits of the cost through each lane 2 stages back
+    float vx, vy, len, vScale, v;
+    int32_t best;
+    int a, c, arg;
+    // segments coming into the lane b of the middle stage
+    for (a = 0; a < k; a++) {
+        ux[a] = px1 - px0[a];
+        uy[a] = py1 - py0[a];
+        len = sqrtf(ux[a] * ux[a] + uy[a] * uy[a]);
+        uInv[a] = len > 0 ? 1 / len : 0;
+    }
+    for (c = 0; c < k; c++) {
+        vx = px2[c] - px1;
+        vy = py2[c] - py1;
+        len = sqrtf(vx * vx + vy * vy);
+        vScale = len > 0 ? weight / len : 0;
+        for (a = 0; a < k; a++) {
+            v = cost[a] + fabsf(ux[a] * vy - uy[a] * vx) * uInv[a] * vScale;
+            memcpy(&value[a], &v, sizeof(v));
+        }
+        best = value[0];
+        for (a = 1; a < k; a++)
+            best = value[a] < best ? value[a] : best;
+        // the first lane with the min
+        arg = k - 1;
+        for (a = k - 1; a >= 0; a--)
+            arg = value[a] == best ? a : arg;
+        memcpy(&v, &best, sizeof(v));
+        newCost[c * k] = v + len;
+        bk[c * k] = arg;
+    }
+}
+
+// Constructor with the number of lanes and the stride.
+TrajDP::TrajDP(int k, int st, float weight)
+{
+    lanes = k;
+    if (lanes < 2)
+        lanes = 2;
+    else if (lanes > MAX_LANES)
+        lanes = MAX_LANES;
+    stride = st < 1 ? 1 : st;
+    curvWeight = weight;
+}
+
+// Compute the candidate positions of a stage in the slot of px and py.
+void TrajDP::candidates(Road &rd, int pt, int slot)
+{
+    float t;
+    for (int j = 0; j < lanes; j++) {
+        t = -MAX_TRAJ + 2 * MAX_TRAJ * j / (lanes - 1);
+        px[slot * lanes + j] = rd.points[pt].pt.x() + rd.roadWidth * t * rd.points[pt].norm.x();
+        py[slot * lanes + j] = rd.points[pt].pt.y() + rd.roadWidth * t * rd.points[pt].norm.y();
+    }
+}
+
+// Find the optimal trajectory on the grid and store it in the road.
+// Returns the cost of the optimal path.
+double TrajDP::optimize(Road &rd, bool redraw)
+{
+    TRACE_SCOPE("TrajDP::optimize");
+    int n = rd.points.size();
+    if (n < 3)
+        return 0;
+    int k = lanes, stages = (n - 2) / stride + 2, s, a, b, arg, s0, s1, s2, p1, p2, i;
+    float weight, best, len, dx, dy;
+    unsigned char *bk;
+    // about four tasks of lanes of the middle stage for each thread of the pool
+    int grain = max(1, k / (4 * sharedPool().size()));
+    // the stage s is at the point s * stride, and the last one at the end of the road
+    vector<int> stagePt(stages);
+    for (s = 0; s < stages - 1; s++)
+        stagePt[s] = s * stride;
+    stagePt[stages - 1] = n - 1;
+
+    weight = curvWeight > 0 ? curvWeight : rd.curvScale;
+    weight *= (rd.points[n - 1].dist - rd.points[0].dist) / (stages - 1);
+    cost.assign(k * k, 0);
+    newCost.assign(k * k, 0);
+    back.assign(stages * k * k, 0); // one byte per state
+    px.assign(3 * k, 0);
+    py.assign(3 * k, 0);
+
+    // the first two stages only have the length of the segment
+    candidates(rd, stagePt[0], 0);
+    candidates(rd, stagePt[1], 1);
+    for (b = 0; b < k; b++)
+        for (a = 0; a < k; a++) {
+            dx = px[k + b] - px[a];
+            dy = py[k + b] - py[a];
+            cost[b * k + a] = sqrt(dx * dx + dy * dy);
+        }
+
+    for (s = 2; s < stages; s++) {
+        s0 = (s - 2) % 3;
+        s1 = (s - 1) % 3;
+        s2 = s % 3;
+        candidates(rd, stagePt[s], s2);
+        bk = &back[s * k * k];
+        // the lanes of the middle stage write different states, so they are
+        // spread over the threads
+        parallel_for(0, k, grain, [&](int first, int last) {
+            for (int b = first; b < last; b++)
+                stageLane(k, &cost[b * k], &px[s0 * k], &py[s0 * k], px[s1 * k + b],
+                          py[s1 * k + b], &px[s2 * k], &py[s2 * k], weight,
+                          &newCost[b], bk + b);
+        });
+        cost.swap(newCost);
+    }
+
+    // the best final state, then follow the back pointers
+    arg = 0;
+    for (i = 1; i < k * k; i++)
+        if (cost[i] < cost[arg])
+            arg = i;
+    best = cost[arg];
+    vector<int> path(stages);
+    path[stages - 1] = arg / k;
+    path[stages - 2] = arg % k;
+    for (s = stages - 1; s >= 2; s--)
+        path[s - 2] = back[s * k * k + path[s] * k + path[s - 1]];
+
+    // interpolate the trajectory between the stages
+    for (s = 0; s < stages - 1; s++) {
+        p1 = stagePt[s];
+        p2 = stagePt[s + 1];
+        for (i = p1; i < p2; i++) {
+            len = LINEAR_INTERP(path[s], path[s + 1], float(i - p1) / (p2 - p1));
+            rd.points[i].traj = -MAX_TRAJ + 2 * MAX_TRAJ * len / (k - 1);
+        }
+    }
+    rd.points[n - 1].traj = -MAX_TRAJ + 2 * MAX_TRAJ * path[stages - 1] / (k - 1);
+    rd.computeTrajPts(0, n);
+    if (redraw)
+        rd.drawTrajFromPoints();
+    return best;
+}
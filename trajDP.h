@@ -0,0 +1,50 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trajDP.h
+   Updated: October 2026
+
+   Definition of a class optimizing the trajectory by dynamic
+   programming over a grid of lateral positions.
+
+**********************************************************************/
+
+#ifndef TRAJ_DP_H
+#define TRAJ_DP_H
+
+#include <vector>
+using namespace std;
+#include "road.h"
+
+#define MAX_LANES 255
+
+// Each stage is a road point, or one in every stride points, and each
+// stage has a number of lanes evenly spread in [-MAX_TRAJ, MAX_TRAJ].
+// The cost of a path is its length plus the curvature at each stage
+// weighted by curvWeight. Since the curvature needs three points, a
+// state is a pair of lanes for the previous and the current stage, and
+// the path found is optimal over the whole grid (Viterbi).
+class TrajDP {
+public:
+    int lanes;        // number of lateral positions in each stage, at most MAX_LANES
+    int stride;       // number of road points from one stage to the next
+    float curvWeight; // cost of the curvature relative to the average stage length
+
+    // Constructor with the number of lanes and the stride.
+    TrajDP(int k = 15, int st = 1, float weight = 0);
+
+    // Find the optimal trajectory on the grid and store it in the road.
+    // Returns the cost of the optimal path.
+    double optimize(Road &rd, bool redraw = true);
+
+private:
+    vector<float> cost, newCost;  // best cost for each state (prev, cur), stored cur * lanes + prev
+    vector<unsigned char> back;   // best lane 2 stages back for each stage and state
+    vector<float> px, py;         // candidate positions in the last 3 stages
+
+    // Compute the candidate positions of a stage in the slot of px and py.
+    void candidates(Road &rd, int pt, int slot);
+};
+
+#endif
@@ -0,0 +1,222 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trajHistory.cc
+   Updated: October 2026
+
+   Implementation of a history of the changes of the trajectory that
+   can be undone and redone. Each change keeps only the range of
+   points it modified, compressed.
+
+**********************************************************************/
+
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <zlib.h>
+#include "trajHistory.h"
+#include "trace.h"
+#include "log.h"
+
+// The bits of a float.
+static uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// The float with these bits.
+static float bitsFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Constructor with the memory budget of the changes in bytes; 0 means the
+// environment variable ROADVIZ_HISTORY in megabytes, or HISTORY_BUDGET.
+TrajHistory::TrajHistory(size_t budget)
+{
+    current = 0;
+    used = 0;
+    if (budget == 0 && getenv("ROADVIZ_HISTORY"))
+        budget = size_t(atoi(getenv("ROADVIZ_HISTORY"))) << 20;
+    if (budget == 0)
+        budget = size_t(HISTORY_BUDGET) << 20;
+    this->budget = budget;
+}
+
+// Change the memory budget, removing the oldest changes if needed.
+void TrajHistory::setBudget(size_t bytes)
+{
+    budget = bytes;
+    trim();
+}
+
+// Forget all the changes and start from the trajectory of the road.
+void TrajHistory::reset(const Road &rd)
+{
+    edits.clear();
+    current = 0;
+    used = 0;
+    shadow.resize(rd.points.size());
+    for (unsigned int i = 0; i < rd.points.size(); i++)
+        shadow[i] = rd.points[i].traj;
+}
+
+// Record the changes of the trajectory since the last record as one
+// operation with that name. The changes that were undone can't be redone
+// anymore. Returns false if nothing changed.
+bool TrajHistory::record(const Road &rd, const string &name)
+{
+    TRACE_SCOPE("TrajHistory::record");
+    int n = rd.points.size(), first = 0, last = n, m, i, k;
+    if (shadow.size() != n) {
+        // a different road, its changes can't be undone
+        reset(rd);
+        return false;
+    }
+    // compare the bits, so that a change of sign of 0 or a nan is restored too
+    while (first < n && floatBits(rd.points[first].traj) == floatBits(shadow[first]))
+        first++;
+    if (first == n)
+        return false;
+    while (floatBits(rd.points[last - 1].traj) == floatBits(shadow[last - 1]))
+        last--;
+
+    // byte k of every value goes to the plane k
+    m = last - first;
+    vector<unsigned char> planes(4 * size_t(m));
+    uint32_t delta;
+    for (i = 0; i < m; i++) {
+        delta = floatBits(rd.points[first + i].traj) ^ floatBits(shadow[first + i]);
+        for (k = 0; k < 4; k++)
+            planes[size_t(k) * m + i] = (delta >> (8 * k)) & 255;
+        shadow[first + i] = rd.points[first + i].traj;
+    }
+    TrajEdit edit;
+    edit.name = name;
+    edit.first = first;
+    edit.last = last;
+    uLongf packedSize = compressBound(planes.size());
+    edit.packed.resize(packedSize);
+    if (compress2(&edit.packed[0], &packedSize, &planes[0], planes.size(),
+                  Z_DEFAULT_COMPRESSION) != Z_OK) {
+        LOG(logError, "Could not compress the change of the trajectory by " << name);
+        reset(rd);
+        return false;
+    }
+    edit.packed.resize(packedSize);
+    edit.packed.shrink_to_fit();
+
+    // the changes undone are lost
+    while (edits.size() > current) {
+        used -= edits.back().packed.size();
+        edits.pop_back();
+    }
+    used += edit.packed.size();
+    edits.push_back(edit);
+    current++;
+    LOG(logDebug, name << " changed the points " << first << " to " << last << " in "
+        << packedSize << " bytes");
+    trim();
+    return true;
+}
+
+// Undo the last operation recorded, then recompute the trajectory points
+// that changed and redraw them. Returns false if there is nothing to undo.
+bool TrajHistory::undo(Road &rd, bool redraw)
+{
+    if (!canUndo() || !apply(rd, edits[current - 1], redraw))
+        return false;
+    current--;
+    return true;
+}
+
+// Redo the last operation undone, then recompute the trajectory points
+// that changed and redraw them. Returns false if there is nothing to redo.
+bool TrajHistory::redo(Road &rd, bool redraw)
+{
+    if (!canRedo() || !apply(rd, edits[current], redraw))
+        return false;
+    current++;
+    return true;
+}
+
+// Are there operations to undo?
+bool TrajHistory::canUndo()
+{
+    return current > 0;
+}
+
+// Are there operations to redo?
+bool TrajHistory::canRedo()
+{
+    return current < edits.size();
+}
+
+// The name of the operation undo would apply.
+const string &TrajHistory::undoName()
+{
+    static const string nothing;
+    return canUndo() ? edits[current - 1].name : nothing;
+}
+
+// The name of the operation redo would apply.
+const string &TrajHistory::redoName()
+{
+    static const string nothing;
+    return canRedo() ? edits[current].name : nothing;
+}
+
+// Memory used by the changes in bytes.
+size_t TrajHistory::memory()
+{
+    return used;
+}
+
+// Remove the oldest changes until the memory used fits in the budget.
+void TrajHistory::trim()
+{
+    while (used > budget && edits.size()) {
+        if (current == 0) {
+            // the changes to redo only apply one after the other from the first
+            edits.clear();
+            used = 0;
+            break;
+        }
+        used -= edits.front().packed.size();
+        edits.pop_front();
+        current--;
+    }
+}
+
+// Turn the road and the shadow into the other side of the edit.
+bool TrajHistory::apply(Road &rd, const TrajEdit &edit, bool redraw)
+{
+    TRACE_SCOPE("TrajHistory::apply");
+    int m = edit.last - edit.first, i, k;
+    if (shadow.size() != rd.points.size() || edit.last > rd.points.size())
+        return false;
+    vector<unsigned char> planes(4 * size_t(m));
+    uLongf planesSize = planes.size();
+    if (uncompress(&planes[0], &planesSize, &edit.packed[0], edit.packed.size()) != Z_OK ||
+        planesSize != planes.size()) {
+        LOG(logError, "Could not read back the change of the trajectory by " << edit.name);
+        return false;
+    }
+    uint32_t delta;
+    for (i = 0; i < m; i++) {
+        delta = 0;
+        for (k = 0; k < 4; k++)
+            delta |= uint32_t(planes[size_t(k) * m + i]) << (8 * k);
+        shadow[edit.first + i] = bitsFloat(floatBits(shadow[edit.first + i]) ^ delta);
+        rd.points[edit.first + i].traj = shadow[edit.first + i];
+    }
+    rd.computeTrajPts(edit.first, edit.last);
+    if (redraw)
+        rd.drawTrajFromPoints();
+    return true;
+}
@@ -0,0 +1,83 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    trajHistory.h
+   Updated: October 2026
+
+   Definition of a history of the changes of the trajectory that can
+   be undone and redone. Each change keeps only the range of points
+   it modified, compressed.
+
+**********************************************************************/
+
+#ifndef TRAJ_HISTORY_H
+#define TRAJ_HISTORY_H
+
+#include <vector>
+#include <deque>
+#include <string>
+using namespace std;
+#include "road.h"
+
+#define HISTORY_BUDGET 64 // megabytes used by the changes when none is given
+
+// One change of the trajectory: the points from first to last, not included,
+// stored as the bits of the old values xor the new ones, which turns into the
+// new values from the old ones and back. The bytes of the same rank of all the
+// values are grouped before compression, so that the unchanged high bytes
+// compress to almost nothing.
+struct TrajEdit {
+    string name; // of the operation that made the change
+    int first, last;
+    vector<unsigned char> packed;
+};
+
+class TrajHistory {
+public:
+    // Constructor with the memory budget of the changes in bytes; 0 means the
+    // environment variable ROADVIZ_HISTORY in megabytes, or HISTORY_BUDGET.
+    TrajHistory(size_t budget = 0);
+
+    // Change the memory budget, removing the oldest changes if needed.
+    void setBudget(size_t bytes);
+
+    // Forget all the changes and start from the trajectory of the road.
+    void reset(const Road &rd);
+
+    // Record the changes of the trajectory since the last record as one
+    // operation with that name. The changes that were undone can't be redone
+    // anymore. Returns false if nothing changed.
+    bool record(const Road &rd, const string &name);
+
+    // Undo the last operation recorded, or redo the last one undone, then
+    // recompute the trajectory points that changed and redraw them. Returns
+    // false if there is nothing to undo or redo.
+    bool undo(Road &rd, bool redraw = true);
+    bool redo(Road &rd, bool redraw = true);
+
+    // Are there operations to undo or to redo?
+    bool canUndo();
+    bool canRedo();
+
+    // The name of the operation undo or redo would apply.
+    const string &undoName();
+    const string &redoName();
+
+    // Memory used by the changes in bytes.
+    size_t memory();
+
+private:
+    vector<float> shadow;  // the trajectory at the last record, undo or redo
+    deque<TrajEdit> edits; // from the oldest to the newest
+    int current;           // the edits before this one are done, the others undone
+    size_t budget, used;
+
+    // Remove the oldest changes until the memory used fits in the budget.
+    void trim();
+
+    // Turn the road and the shadow into the other side of the edit.
+    bool apply(Road &rd, const TrajEdit &edit, bool redraw);
+};
+
+#endif
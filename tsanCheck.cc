@@ -0,0 +1,96 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    tsanCheck.cc
+   Updated: October 2026
+
+   Check of the thread safety of the road core, built and run with
+   "make tsan" under ThreadSanitizer. Two roads are read, interpolated
+   with quadratic curves and colored by two threads at the same time,
+   then two threads color the same road.
+
+**********************************************************************/
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "road.h"
+#include "roadGen.h"
+#include "trajColor.h"
+#include "log.h"
+
+#define TSAN_POINTS 2000 // points of each generated centerline
+#define TSAN_STEP 0.05   // step of the interpolation
+
+// Read the road with the linear interpolation, go through the quadratic
+// curve between each pair of points, give it a trajectory, and compute its
+// colors in all the modes. Returns false if the road could not be read.
+static bool readAndColor(Road &rd, string filename, ThreadPool &pool)
+{
+    rd.readCenter(&filename[0], linear, TSAN_STEP);
+    int n = rd.points.size();
+    if (n <= TSAN_POINTS) // not resampled
+        return false;
+    QuadCurve curve;
+    RoadPt middle;
+    for (int i = 0; i + 1 < n; i++) {
+        middle.quadraticInterpolate(rd.points[i], rd.points[i + 1], 0, curve);
+        middle.quadraticInterpolate(rd.points[i], rd.points[i + 1], 0.5, curve);
+    }
+    for (int i = 0; i < n; i++)
+        rd.points[i].traj = 0.5 * sin(i * 0.01);
+    rd.computeTrajPts(0, n);
+    rd.findKeyFrames();
+    vector<GLfloat> colors(3 * n);
+    for (int mode = 0; mode < nrColorModes; mode++)
+        computeTrajColors(rd, TrajColorMode(mode), 0, n, &colors[0], 3, pool);
+    return true;
+}
+
+// Compute the colors of the road in all the modes, only reading it.
+static void colorOnly(const Road &rd, ThreadPool &pool)
+{
+    int n = rd.points.size();
+    vector<GLfloat> colors(3 * n);
+    for (int mode = 0; mode < nrColorModes; mode++)
+        computeTrajColors(rd, TrajColorMode(mode), 0, n, &colors[0], 3, pool);
+}
+
+int main()
+{
+    setLogLevel(logError);
+    string prefix = "/tmp/roadviz_tsan_" + to_string(getpid());
+    string files[2] = {prefix + "_a.txt", prefix + "_b.txt"};
+    for (int r = 0; r < 2; r++)
+        if (!writeGenRoad(files[r].c_str(), TSAN_POINTS, 0.2, r + 1, r == 1, true)) {
+            cout << "Could not write the road in " << files[r] << endl;
+            return 1;
+        }
+
+    // two roads on two threads, each with its own pool and with the shared one
+    Road roads[2];
+    ThreadPool pool(2);
+    bool read[2] = {false, false};
+    thread other([&]() { read[1] = readAndColor(roads[1], files[1], sharedPool()); });
+    read[0] = readAndColor(roads[0], files[0], pool);
+    other.join();
+
+    // two threads on the same road
+    if (read[0]) {
+        thread second([&]() { colorOnly(roads[0], sharedPool()); });
+        colorOnly(roads[0], pool);
+        second.join();
+    }
+    for (int r = 0; r < 2; r++)
+        unlink(files[r].c_str());
+    logFlush();
+    if (!read[0] || !read[1]) {
+        cout << "The interpolation did not resample the roads" << endl;
+        return 1;
+    }
+    cout << "Roads of " << roads[0].points.size() << " and " << roads[1].points.size()
+         << " points read and colored at the same time" << endl;
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    vbBench.cc
+   Updated: October 2026
+
+   Measure of the vertex buffers without a window, built with "make
+   vbbench". An OpenGL context is made with EGL on a pbuffer, which
+   Mesa can render in software, and a buffer of a million vertices is
+   sent whole and in part, then drawn.
+
+**********************************************************************/
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include "vertexBuffer.h"
+
+#define VB_VERTICES 1000000 // size of the buffer measured
+#define VB_REPS 20          // times each measure is repeated, the median is output
+
+// Seconds since an arbitrary start.
+static double now()
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Make an OpenGL context current on a small pbuffer, without any window.
+// The surfaceless platform of Mesa is tried first, then the default display.
+static bool makeContext()
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+            return false;
+    }
+    const EGLint configAttr[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                 EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                 EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+                                 EGL_NONE};
+    const EGLint surfaceAttr[] = {EGL_WIDTH, 1024, EGL_HEIGHT, 1024, EGL_NONE};
+    EGLConfig config;
+    EGLint nrConfigs = 0;
+    if (!eglChooseConfig(display, configAttr, &config, 1, &nrConfigs) || nrConfigs < 1)
+        return false;
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttr);
+    if (surface == EGL_NO_SURFACE || !eglBindAPI(EGL_OPENGL_API))
+        return false;
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    if (context == EGL_NO_CONTEXT)
+        return false;
+    return eglMakeCurrent(display, surface, surface, context);
+}
+
+// Median time of VB_REPS calls of the function in milliseconds, each one
+// finished by glFinish so that the driver really did the work.
+template <class F>
+static double timeGL(F work)
+{
+    vector<double> times;
+    double start;
+    for (int r = 0; r < VB_REPS; r++) {
+        start = now();
+        work();
+        glFinish();
+        times.push_back(1000 * (now() - start));
+    }
+    sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main()
+{
+    if (!makeContext()) {
+        cout << "Could not make an OpenGL context with EGL" << endl;
+        return 1;
+    }
+    cout << "Renderer: " << glGetString(GL_RENDERER) << endl;
+    glViewport(0, 0, 1024, 1024);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, VB_VERTICES, -1, 1, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    VertexBuffer buf(GL_LINE_STRIP);
+    for (int i = 0; i < VB_VERTICES; i++)
+        buf.add(i, (i % 200) / 100.0 - 1, 1, 1, 0);
+    buf.upload();
+
+    double full = timeGL([&]() { buf.upload(); });
+    cout << "Full upload of " << VB_VERTICES << " vertices: " << full << " ms" << endl;
+    int sizes[] = {1000, 10000, 100000};
+    for (int s = 0; s < 3; s++) {
+        // a change in the middle of the road, as after a local optimization
+        int first = (VB_VERTICES - sizes[s]) / 2;
+        double part = timeGL([&]() {
+            for (int i = first; i < first + sizes[s]; i++)
+                buf.data[i * VB_STRIDE + 1] = -buf.data[i * VB_STRIDE + 1];
+            buf.update(first, first + sizes[s]);
+        });
+        cout << "Partial update of " << sizes[s] << " vertices: " << part << " ms ("
+             << full / part << " times faster)" << endl;
+    }
+    double draw = timeGL([&]() {
+        glClear(GL_COLOR_BUFFER_BIT);
+        buf.draw();
+    });
+    cout << "Draw of " << VB_VERTICES << " vertices: " << draw << " ms" << endl;
+    return 0;
+}
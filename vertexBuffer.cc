@@ -0,0 +1,175 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    vertexBuffer.cc
+   Updated: October 2026
+
+   Definition of a class storing 2D colored vertices in an OpenGL
+   vertex buffer object and drawing them in one call.
+
+**********************************************************************/
+
+// the buffer functions are from OpenGL 1.5, declared in glext.h
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glut.h>
+#include "vertexBuffer.h"
+#include "trace.h"
+
+// Constructor: nothing changed.
+DirtyRange::DirtyRange()
+{
+    clear();
+}
+
+// Add the vertices from first to last, not included, to the range.
+void DirtyRange::mark(int first, int last)
+{
+    if (first >= last)
+        return;
+    if (empty()) {
+        start = first;
+        end = last;
+    }
+    else {
+        if (first < start)
+            start = first;
+        if (last > end)
+            end = last;
+    }
+}
+
+// Did anything change?
+bool DirtyRange::empty()
+{
+    return start >= end;
+}
+
+// Nothing changed anymore.
+void DirtyRange::clear()
+{
+    start = end = 0;
+}
+
+// Constructor with the type of primitive.
+VertexBuffer::VertexBuffer(GLenum primitive)
+{
+    mode = primitive;
+    id = 0;
+    uploaded = 0;
+}
+
+// Copies only get the data, the buffer object belongs to the original.
+VertexBuffer::VertexBuffer(const VertexBuffer &other)
+{
+    data = other.data;
+    mode = other.mode;
+    id = 0;
+    uploaded = 0;
+}
+
+// Copies only get the data, the buffer object belongs to the original.
+VertexBuffer &VertexBuffer::operator=(const VertexBuffer &other)
+{
+    if (this != &other) {
+        data = other.data;
+        mode = other.mode;
+        uploaded = 0;
+    }
+    return *this;
+}
+
+// Destructor: deletes the buffer object if there is one.
+VertexBuffer::~VertexBuffer()
+{
+    if (id)
+        glDeleteBuffers(1, &id);
+}
+
+// Remove all the vertices.
+void VertexBuffer::clear()
+{
+    data.clear();
+}
+
+// Add a vertex with a color.
+void VertexBuffer::add(GLfloat x, GLfloat y, GLfloat red, GLfloat green, GLfloat blue)
+{
+    data.push_back(x);
+    data.push_back(y);
+    data.push_back(red);
+    data.push_back(green);
+    data.push_back(blue);
+}
+
+// Number of vertices stored.
+int VertexBuffer::size()
+{
+    return data.size() / VB_STRIDE;
+}
+
+// Change the position and color of the vertex i.
+void VertexBuffer::set(int i, GLfloat x, GLfloat y, GLfloat red, GLfloat green, GLfloat blue)
+{
+    GLfloat *vertex = &data[i * VB_STRIDE];
+    vertex[0] = x;
+    vertex[1] = y;
+    vertex[2] = red;
+    vertex[3] = green;
+    vertex[4] = blue;
+}
+
+// Send all the vertices to the buffer object, creating it if needed.
+void VertexBuffer::upload()
+{
+    TRACE_SCOPE("VertexBuffer::upload");
+    if (!id)
+        glGenBuffers(1, &id);
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(GLfloat),
+                 data.size() ? &data[0] : NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploaded = size();
+}
+
+// Send only the vertices from first to last, not included, to the buffer object.
+// The number of vertices must not have changed since the last upload.
+void VertexBuffer::update(int first, int last)
+{
+    if (!id || size() != uploaded) {
+        upload();
+        return;
+    }
+    if (first < 0)
+        first = 0;
+    if (last > uploaded)
+        last = uploaded;
+    if (first >= last)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glBufferSubData(GL_ARRAY_BUFFER, first * VB_STRIDE * sizeof(GLfloat),
+                    (last - first) * VB_STRIDE * sizeof(GLfloat), &data[first * VB_STRIDE]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Draw the vertices from the buffer object.
+void VertexBuffer::draw()
+{
+    drawRange(0, uploaded);
+}
+
+// Draw count vertices from the buffer object starting from first.
+void VertexBuffer::drawRange(int first, int count)
+{
+    if (!id || first < 0 || count <= 0 || first + count > uploaded)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, VB_STRIDE * sizeof(GLfloat), (GLvoid *)0);
+    glColorPointer(3, GL_FLOAT, VB_STRIDE * sizeof(GLfloat), (GLvoid *)(2 * sizeof(GLfloat)));
+    glDrawArrays(mode, first, count);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
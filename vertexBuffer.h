@@ -0,0 +1,83 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    vertexBuffer.h
+   Updated: October 2026
+
+   Definition of a class storing 2D colored vertices in an OpenGL
+   vertex buffer object and drawing them in one call.
+
+**********************************************************************/
+
+#ifndef VERTEX_BUFFER_H
+#define VERTEX_BUFFER_H
+
+#include <GL/glut.h>
+#include <vector>
+using namespace std;
+
+#define VB_STRIDE 5 // x, y, red, green, blue
+
+// The range of vertices that changed since the last upload.
+class DirtyRange {
+public:
+    int start, end; // empty if start >= end
+
+    // Constructor: nothing changed.
+    DirtyRange();
+
+    // Add the vertices from first to last, not included, to the range.
+    void mark(int first, int last);
+
+    // Did anything change?
+    bool empty();
+
+    // Nothing changed anymore.
+    void clear();
+};
+
+class VertexBuffer {
+public:
+    vector<GLfloat> data; // interleaved positions and colors
+    GLenum mode;          // the primitive drawn with the vertices
+
+    // Constructor with the type of primitive.
+    VertexBuffer(GLenum primitive = GL_LINE_STRIP);
+    // Copies only get the data, the buffer object belongs to the original.
+    VertexBuffer(const VertexBuffer &other);
+    VertexBuffer &operator=(const VertexBuffer &other);
+    // Destructor: deletes the buffer object if there is one.
+    ~VertexBuffer();
+
+    // Remove all the vertices.
+    void clear();
+
+    // Add a vertex with a color.
+    void add(GLfloat x, GLfloat y, GLfloat red, GLfloat green, GLfloat blue);
+
+    // Number of vertices stored.
+    int size();
+
+    // Change the position and color of the vertex i.
+    void set(int i, GLfloat x, GLfloat y, GLfloat red, GLfloat green, GLfloat blue);
+
+    // Send all the vertices to the buffer object, creating it if needed.
+    void upload();
+
+    // Send only the vertices from first to last, not included, to the buffer object.
+    // The number of vertices must not have changed since the last upload.
+    void update(int first, int last);
+
+    // Draw the vertices from the buffer object.
+    void draw();
+
+    // Draw count vertices from the buffer object starting from first.
+    void drawRange(int first, int count);
+
+private:
+    GLuint id;    // the buffer object, 0 if it wasn't created yet
+    int uploaded; // number of vertices in the buffer object
+};
+
+#endif
@@ -0,0 +1,44 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    view.cc
+   Updated: October 2026
+
+   Functions fitting the view around an area of the plane, shared by
+   the window and the pictures drawn without it.
+
+**********************************************************************/
+
+#include <cmath>
+#include "view.h"
+
+// Set the view on the coordinate i so that we can see the whole area.
+void setView(Point3f &vMin, Point3f &vMax, int i)
+{
+    if (vMin[i] == vMax[i])
+    {
+        vMin[i] = 0;
+        vMax[i] = 1;
+    }
+    else if (fabs(vMin[i]) < fabs(vMax[i]))
+    {
+        vMax[i] *= 1.1;
+        vMin[i] -= 0.09091 * vMax[i];
+    }
+    else
+    {
+        vMin[i] *= 1.1;
+        vMax[i] -= 0.09091 * vMin[i];
+    }
+}
+
+// Shrink the width or the height of the window so that it has the same
+// proportions as a view of size viewW x viewH.
+void fitWindow(float viewW, float viewH, int &width, int &height)
+{
+    if (viewW / viewH > float(width) / height) // the view is larger than the window
+        height = width * (viewH / viewW);
+    else
+        width = height * (viewW / viewH);
+}
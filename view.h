@@ -0,0 +1,25 @@
+/**********************************************************************
+   Project: Gl Visualizer
+   License: Creative Commons, Attribution
+   Author:  Dana Vrajitoru
+   File:    view.h
+   Updated: October 2026
+
+   Functions fitting the view around an area of the plane, shared by
+   the window and the pictures drawn without it.
+
+**********************************************************************/
+
+#ifndef VIEW_H
+#define VIEW_H
+
+#include "point3f.h"
+
+// Set the view on the coordinate i so that we can see the whole area.
+void setView(Point3f &vMin, Point3f &vMax, int i);
+
+// Shrink the width or the height of the window so that it has the same
+// proportions as a view of size viewW x viewH.
+void fitWindow(float viewW, float viewH, int &width, int &height);
+
+#endif